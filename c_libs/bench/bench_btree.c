@@ -0,0 +1,204 @@
+/* =================================
+Benchmark of the B+tree against the AVL tree:
+random inserts, point lookups, lower bounds and a full in order scan,
+then lookups in a flat map bulk built from the same keys
+
+usage: bench_btree [element count ...]
+default 1000000, the B+tree is meant for 1M to 100M keys
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../include/avl.h"
+#include "../include/btree.h"
+#include "../include/flat_map.h"
+
+
+static double now_millis() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static int uint_cmp(const void* a, const void* b) {
+	uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+	return (x > y) - (x < y);
+}
+
+static int scan_sum(const void* key, const void* data, void* arg) {
+	*(unsigned long*)arg += *(const uint32_t*)data;
+	return 0;
+}
+
+static void shuffle(uint32_t* array, size_t n, uint64_t* state) {
+	for (size_t i = n; i > 1; i--) {
+		*state ^= *state << 13;
+		*state ^= *state >> 7;
+		*state ^= *state << 17;
+		size_t j = *state % i;
+		uint32_t tmp = array[i - 1];
+		array[i - 1] = array[j];
+		array[j] = tmp;
+	}
+}
+
+static void report(const char* name, double avl, const char* other, double other_ms, unsigned long check_avl, unsigned long check_other) {
+	printf("%-22s avl %10.2f ms   %-8s %10.2f ms   speedup %5.2fx%s\n", name, avl, other, other_ms,
+		avl / (other_ms > 0 ? other_ms : 1e-9), check_avl == check_other ? "" : "   MISMATCH");
+}
+
+static void bench(size_t n) {
+	// distinct odd keys: multiplication by an odd constant is a bijection
+	// and maps odd numbers to odd numbers
+	uint32_t* keys = malloc(n * sizeof(uint32_t));
+	if (!keys)
+		return;
+	for (size_t i = 0; i < n; i++)
+		keys[i] = (uint32_t)((2 * i + 1) * 2654435761u);
+
+	// lookups use a second shuffle, replaying the insertion order would favour
+	// the AVL tree whose nodes sit in memory in that same order
+	uint32_t* probe = malloc(n * sizeof(uint32_t));
+	if (!probe) {
+		free(keys);
+		return;
+	}
+	uint64_t state = 88172645463325252ull;
+	shuffle(keys, n, &state);
+	for (size_t i = 0; i < n; i++)
+		probe[i] = keys[i];
+	shuffle(probe, n, &state);
+
+	avl_tree_t* avl = avl_tree_init(sizeof(uint32_t), sizeof(uint32_t), uint_cmp);
+	btree_t* btree = btree_init(sizeof(uint32_t), sizeof(uint32_t), uint_cmp);
+	if (!avl || !btree) {
+		free(probe);
+		free(keys);
+		return;
+	}
+
+	printf("%zu elements\n", n);
+
+	double start = now_millis();
+	for (size_t i = 0; i < n; i++)
+		avl_tree_insert(avl, &keys[i], &keys[i]);
+	double avl_ms = now_millis() - start;
+
+	start = now_millis();
+	for (size_t i = 0; i < n; i++)
+		btree_insert(btree, &keys[i], &keys[i]);
+	double btree_ms = now_millis() - start;
+	report("insert", avl_ms, "btree", btree_ms, avl_tree_count(avl), btree_count(btree));
+
+	unsigned long sum_avl = 0, sum_btree = 0;
+	start = now_millis();
+	for (size_t i = 0; i < n; i++)
+		sum_avl += *(const uint32_t*)avl_tree_search(avl, &probe[i]);
+	avl_ms = now_millis() - start;
+
+	start = now_millis();
+	for (size_t i = 0; i < n; i++)
+		sum_btree += *(const uint32_t*)btree_search(btree, &probe[i]);
+	btree_ms = now_millis() - start;
+	report("search", avl_ms, "btree", btree_ms, sum_avl, sum_btree);
+
+	// even keys are never present, so every lookup ends between two keys
+	sum_avl = sum_btree = 0;
+	start = now_millis();
+	for (size_t i = 0; i < n; i++) {
+		uint32_t key = probe[i] - 1;
+		const uint32_t* found = avl_lower_bound(avl, &key);
+		sum_avl += found ? *found : 0;
+	}
+	avl_ms = now_millis() - start;
+
+	start = now_millis();
+	for (size_t i = 0; i < n; i++) {
+		uint32_t key = probe[i] - 1;
+		const uint32_t* found = btree_lower_bound(btree, &key);
+		sum_btree += found ? *found : 0;
+	}
+	btree_ms = now_millis() - start;
+	report("lower bound", avl_ms, "btree", btree_ms, sum_avl, sum_btree);
+
+	// the flat map is built in one go, it is meant for read mostly data
+	flat_map_t* flat = flat_map_init(sizeof(uint32_t), sizeof(uint32_t), uint_cmp);
+	if (flat && flat_map_build(flat, keys, keys, n) == OK) {
+		unsigned long sum_flat = 0;
+		sum_avl = 0;
+		start = now_millis();
+		for (size_t i = 0; i < n; i++)
+			sum_avl += *(const uint32_t*)avl_tree_search(avl, &probe[i]);
+		avl_ms = now_millis() - start;
+
+		start = now_millis();
+		for (size_t i = 0; i < n; i++)
+			sum_flat += *(const uint32_t*)flat_map_search(flat, &probe[i]);
+		double flat_ms = now_millis() - start;
+		report("search", avl_ms, "flat_map", flat_ms, sum_avl, sum_flat);
+
+		sum_avl = sum_flat = 0;
+		start = now_millis();
+		for (size_t i = 0; i < n; i++) {
+			uint32_t key = probe[i] - 1;
+			const uint32_t* found = avl_lower_bound(avl, &key);
+			sum_avl += found ? *found : 0;
+		}
+		avl_ms = now_millis() - start;
+
+		start = now_millis();
+		for (size_t i = 0; i < n; i++) {
+			uint32_t key = probe[i] - 1;
+			const uint32_t* found = flat_map_lower_bound(flat, &key);
+			sum_flat += found ? *found : 0;
+		}
+		flat_ms = now_millis() - start;
+		report("lower bound", avl_ms, "flat_map", flat_ms, sum_avl, sum_flat);
+	}
+	flat_map_delete(flat);
+
+	sum_avl = sum_btree = 0;
+	start = now_millis();
+	avl_range_scan(avl, NULL, NULL, scan_sum, &sum_avl);
+	avl_ms = now_millis() - start;
+
+	start = now_millis();
+	btree_range_scan(btree, NULL, NULL, scan_sum, &sum_btree);
+	btree_ms = now_millis() - start;
+	report("full scan", avl_ms, "btree", btree_ms, sum_avl, sum_btree);
+
+	start = now_millis();
+	for (size_t i = 0; i < n; i += 2)
+		avl_tree_erase(avl, &probe[i]);
+	avl_ms = now_millis() - start;
+
+	start = now_millis();
+	for (size_t i = 0; i < n; i += 2)
+		btree_erase(btree, &probe[i]);
+	btree_ms = now_millis() - start;
+	report("erase half", avl_ms, "btree", btree_ms, avl_tree_count(avl), btree_count(btree));
+
+	avl_tree_delete(avl);
+	btree_delete(btree);
+	free(probe);
+	free(keys);
+}
+
+
+int main(int argc, char *argv[]) {
+	if (argc < 2) {
+		bench(1000000);
+		return 0;
+	}
+
+	for (int i = 1; i < argc; i++) {
+		long n = atol(argv[i]);
+		if (n > 0)
+			bench(n);
+	}
+
+	return 0;
+}
@@ -0,0 +1,380 @@
+/* =================================
+Benchmark of the heap variants: bheap, bheap2 and the 4-ary and 8-ary dheap
+across element sizes and heap sizes, reported in nanoseconds per operation
+
+fill: insert n random elements then pop all of them
+hold: keep n elements and repeatedly pop the top and insert a later one,
+      the usual event queue pattern
+dijkstra: shortest paths on a random graph with the plain heaps holding
+      duplicates, the indexed heap using decrease key and the radix heap
+
+usage: bench_heap [heap size ...]
+default 1000 100000 1000000
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "../include/binary_heap.h"
+#include "../include/dary_heap.h"
+#include "../include/indexed_heap.h"
+#include "../include/radix_heap.h"
+
+#define HOLD_OPS 1000000
+#define MAX_ELEM 64
+
+#define GRAPH_NODES 200000
+#define GRAPH_DEGREE 8
+#define UNREACHED UINT64_MAX
+
+typedef struct heap_ops_s {
+	const char* name;
+	void* (*init)(size_t capacity, size_t data_size);
+	void (*insert)(void* heap, const void* data);
+	const void* (*top)(void* heap);
+	void (*pop)(void* heap);
+	void (*destroy)(void* heap);
+} heap_ops_t;
+
+
+static double now_millis() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// every element starts with its uint32_t key, the rest is payload
+static uint8_t key_after(const void* a, const void* b) {
+	return *(const uint32_t*)a > *(const uint32_t*)b;
+}
+
+static void* bheap_new(size_t capacity, size_t data_size) { return bheap_init(capacity, data_size, key_after); }
+static void bheap_push(void* heap, const void* data) { bheap_insert(heap, (void*)data); }
+static const void* bheap_top(void* heap) { return bheap_get_top(heap); }
+static void bheap_drop(void* heap) { bheap_pop(heap); }
+static void bheap_free(void* heap) { bheap_delete(heap); }
+
+static void* bheap2_new(size_t capacity, size_t data_size) { return bheap2_init(capacity, data_size, key_after); }
+static void bheap2_push(void* heap, const void* data) { bheap2_insert(heap, (void*)data); }
+static const void* bheap2_top(void* heap) { return bheap2_get_top(heap); }
+static void bheap2_drop(void* heap) { bheap2_pop(heap); }
+static void bheap2_free(void* heap) { bheap2_delete(heap); }
+
+static void* dheap4_new(size_t capacity, size_t data_size) { return dheap_init(capacity, data_size, 4, key_after); }
+static void* dheap8_new(size_t capacity, size_t data_size) { return dheap_init(capacity, data_size, 8, key_after); }
+static void dheap_push(void* heap, const void* data) { dheap_insert(heap, data); }
+static const void* dheap_top(void* heap) { return dheap_get_top(heap); }
+static void dheap_drop(void* heap) { dheap_pop(heap); }
+static void dheap_free(void* heap) { dheap_delete(heap); }
+
+static const heap_ops_t heaps[] = {
+	{"bheap", bheap_new, bheap_push, bheap_top, bheap_drop, bheap_free},
+	{"bheap2", bheap2_new, bheap2_push, bheap2_top, bheap2_drop, bheap2_free},
+	{"dheap/4", dheap4_new, dheap_push, dheap_top, dheap_drop, dheap_free},
+	{"dheap/8", dheap8_new, dheap_push, dheap_top, dheap_drop, dheap_free},
+};
+
+#define HEAP_COUNT (sizeof(heaps) / sizeof(heaps[0]))
+
+
+static uint32_t next_random(uint32_t* state) {
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+// ns per operation, an insert and a pop count as two, the key sum goes to checksum
+static double bench_fill(const heap_ops_t* ops, size_t n, size_t elem, unsigned long* checksum) {
+	unsigned char element[MAX_ELEM];
+	memset(element, 0x5a, sizeof(element));
+	uint32_t state = 2463534242u;
+
+	void* heap = ops->init(1, elem);
+	if (!heap)
+		return 0;
+
+	double start = now_millis();
+	for (size_t i = 0; i < n; i++) {
+		uint32_t key = next_random(&state);
+		memcpy(element, &key, sizeof(key));
+		ops->insert(heap, element);
+	}
+	for (size_t i = 0; i < n; i++) {
+		*checksum = *checksum * 31 + *(const uint32_t*)ops->top(heap);
+		ops->pop(heap);
+	}
+	double elapsed = now_millis() - start;
+
+	ops->destroy(heap);
+	return elapsed * 1e6 / (2.0 * n);
+}
+
+static double bench_hold(const heap_ops_t* ops, size_t n, size_t elem, unsigned long* checksum) {
+	unsigned char element[MAX_ELEM];
+	memset(element, 0x5a, sizeof(element));
+	uint32_t state = 88675123u;
+
+	void* heap = ops->init(n, elem);
+	if (!heap)
+		return 0;
+
+	for (size_t i = 0; i < n; i++) {
+		uint32_t key = next_random(&state) >> 4;
+		memcpy(element, &key, sizeof(key));
+		ops->insert(heap, element);
+	}
+
+	double start = now_millis();
+	for (size_t i = 0; i < HOLD_OPS; i++) {
+		uint32_t key = *(const uint32_t*)ops->top(heap);
+		*checksum = *checksum * 31 + key;
+		ops->pop(heap);
+
+		key += next_random(&state) >> 12;
+		memcpy(element, &key, sizeof(key));
+		ops->insert(heap, element);
+	}
+	double elapsed = now_millis() - start;
+
+	ops->destroy(heap);
+	return elapsed * 1e6 / (2.0 * HOLD_OPS);
+}
+
+static void bench(size_t n) {
+	static const size_t sizes[] = {4, 16, 64};
+
+	printf("\n%zu elements, ns per operation\n", n);
+	printf("%-6s %-5s", "bytes", "test");
+	for (size_t h = 0; h < HEAP_COUNT; h++)
+		printf(" %10s", heaps[h].name);
+	printf("\n");
+
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		for (int test = 0; test < 2; test++) {
+			unsigned long first = 0;
+			int mismatch = 0;
+
+			printf("%-6zu %-5s", sizes[s], test ? "hold" : "fill");
+			for (size_t h = 0; h < HEAP_COUNT; h++) {
+				unsigned long checksum = 0;
+				double ns = test ? bench_hold(&heaps[h], n, sizes[s], &checksum)
+					: bench_fill(&heaps[h], n, sizes[s], &checksum);
+				printf(" %10.1f", ns);
+				fflush(stdout);
+
+				if (h == 0)
+					first = checksum;
+				else if (checksum != first)
+					mismatch = 1;
+			}
+			printf("%s\n", mismatch ? "   MISMATCH" : "");
+		}
+	}
+}
+
+
+// adjacency in compressed rows, the edges of node i are first[i] ... first[i + 1] - 1
+typedef struct graph_s {
+	size_t nodes;
+	size_t* first;
+	uint32_t* target;
+	uint32_t* weight;
+} graph_t;
+
+typedef struct path_entry_s {
+	uint64_t distance;
+	uint32_t node;
+} path_entry_t;
+
+static uint8_t path_after(const void* a, const void* b) {
+	return ((const path_entry_t*)a)->distance > ((const path_entry_t*)b)->distance;
+}
+
+static int graph_init(graph_t* graph, size_t nodes, size_t degree) {
+	uint32_t state = 1234567u;
+
+	graph->nodes = nodes;
+	graph->first = malloc((nodes + 1) * sizeof(size_t));
+	graph->target = malloc(nodes * degree * sizeof(uint32_t));
+	graph->weight = malloc(nodes * degree * sizeof(uint32_t));
+	if (!graph->first || !graph->target || !graph->weight)
+		return 0;
+
+	for (size_t i = 0; i < nodes; i++) {
+		graph->first[i] = i * degree;
+		for (size_t e = 0; e < degree; e++) {
+			graph->target[i * degree + e] = next_random(&state) % nodes;
+			graph->weight[i * degree + e] = 1 + next_random(&state) % 1000;
+		}
+	}
+	graph->first[nodes] = nodes * degree;
+
+	return 1;
+}
+
+static void graph_free(graph_t* graph) {
+	free(graph->first);
+	free(graph->target);
+	free(graph->weight);
+}
+
+// sum of the distances from node 0, which every variant has to agree on
+static unsigned long distance_sum(const uint64_t* distance, size_t nodes) {
+	unsigned long sum = 0;
+	for (size_t i = 0; i < nodes; i++)
+		if (distance[i] != UNREACHED)
+			sum += distance[i];
+	return sum;
+}
+
+// plain heaps can not move an element, so a shorter path pushes a duplicate
+// and stale entries are skipped when they come out
+static double dijkstra_lazy(const heap_ops_t* ops, const graph_t* graph, uint64_t* distance) {
+	for (size_t i = 0; i < graph->nodes; i++)
+		distance[i] = UNREACHED;
+
+	double start = now_millis();
+	void* heap = ops->init(graph->nodes, sizeof(path_entry_t));
+	path_entry_t entry = {0, 0};
+	distance[0] = 0;
+	ops->insert(heap, &entry);
+
+	const void* top;
+	while ((top = ops->top(heap)) != NULL) {
+		entry = *(const path_entry_t*)top;
+		ops->pop(heap);
+		if (entry.distance != distance[entry.node])
+			continue;
+
+		for (size_t e = graph->first[entry.node]; e < graph->first[entry.node + 1]; e++) {
+			path_entry_t next = {entry.distance + graph->weight[e], graph->target[e]};
+			if (next.distance < distance[next.node]) {
+				distance[next.node] = next.distance;
+				ops->insert(heap, &next);
+			}
+		}
+	}
+
+	ops->destroy(heap);
+	return now_millis() - start;
+}
+
+static double dijkstra_indexed(const graph_t* graph, uint64_t* distance) {
+	iheap_handle_t* handle = malloc(graph->nodes * sizeof(iheap_handle_t));
+	if (!handle)
+		return 0;
+	for (size_t i = 0; i < graph->nodes; i++) {
+		distance[i] = UNREACHED;
+		handle[i] = IHEAP_NONE;
+	}
+
+	double start = now_millis();
+	iheap_t* heap = iheap_init(graph->nodes, sizeof(path_entry_t), path_after);
+	path_entry_t entry = {0, 0};
+	distance[0] = 0;
+	iheap_push(heap, &entry, &handle[0]);
+
+	while (iheap_count(heap) > 0) {
+		entry = *(const path_entry_t*)iheap_get_top(heap);
+		iheap_pop(heap);
+		handle[entry.node] = IHEAP_NONE;
+
+		for (size_t e = graph->first[entry.node]; e < graph->first[entry.node + 1]; e++) {
+			path_entry_t next = {entry.distance + graph->weight[e], graph->target[e]};
+			if (next.distance < distance[next.node]) {
+				// a reached node with no handle was already settled, which a shorter path rules out
+				if (distance[next.node] == UNREACHED)
+					iheap_push(heap, &next, &handle[next.node]);
+				else
+					iheap_decrease_key(heap, handle[next.node], &next);
+				distance[next.node] = next.distance;
+			}
+		}
+	}
+
+	iheap_delete(heap);
+	double elapsed = now_millis() - start;
+	free(handle);
+	return elapsed;
+}
+
+static double dijkstra_radix(const graph_t* graph, uint64_t* distance) {
+	for (size_t i = 0; i < graph->nodes; i++)
+		distance[i] = UNREACHED;
+
+	double start = now_millis();
+	radix_heap_t* heap = radix_heap_init(sizeof(uint32_t));
+	uint32_t node = 0;
+	uint64_t key = 0;
+	distance[0] = 0;
+	radix_heap_push(heap, 0, &node);
+
+	while (radix_heap_pop(heap, &key, &node) == OK) {
+		if (key != distance[node])
+			continue;
+
+		for (size_t e = graph->first[node]; e < graph->first[node + 1]; e++) {
+			uint32_t next = graph->target[e];
+			uint64_t next_distance = key + graph->weight[e];
+			if (next_distance < distance[next]) {
+				distance[next] = next_distance;
+				radix_heap_push(heap, next_distance, &next);
+			}
+		}
+	}
+
+	radix_heap_delete(heap);
+	return now_millis() - start;
+}
+
+static void bench_dijkstra() {
+	graph_t graph;
+	uint64_t* distance = malloc(GRAPH_NODES * sizeof(uint64_t));
+	if (!graph_init(&graph, GRAPH_NODES, GRAPH_DEGREE) || !distance) {
+		graph_free(&graph);
+		free(distance);
+		return;
+	}
+
+	printf("\ndijkstra, %d nodes %d edges\n", GRAPH_NODES, GRAPH_NODES * GRAPH_DEGREE);
+
+	double ms = dijkstra_lazy(&heaps[0], &graph, distance);
+	unsigned long expected = distance_sum(distance, graph.nodes);
+	printf("%-24s %10.2f ms\n", "bheap duplicates", ms);
+
+	ms = dijkstra_lazy(&heaps[2], &graph, distance);
+	printf("%-24s %10.2f ms%s\n", "dheap/4 duplicates", ms, distance_sum(distance, graph.nodes) == expected ? "" : "   MISMATCH");
+
+	ms = dijkstra_indexed(&graph, distance);
+	printf("%-24s %10.2f ms%s\n", "iheap decrease key", ms, distance_sum(distance, graph.nodes) == expected ? "" : "   MISMATCH");
+
+	ms = dijkstra_radix(&graph, distance);
+	printf("%-24s %10.2f ms%s\n", "radix heap duplicates", ms, distance_sum(distance, graph.nodes) == expected ? "" : "   MISMATCH");
+
+	graph_free(&graph);
+	free(distance);
+}
+
+
+int main(int argc, char *argv[]) {
+	if (argc < 2) {
+		bench(1000);
+		bench(100000);
+		bench(1000000);
+		bench_dijkstra();
+		return 0;
+	}
+
+	for (int i = 1; i < argc; i++) {
+		long n = atol(argv[i]);
+		if (n > 0)
+			bench((size_t)n);
+	}
+	bench_dijkstra();
+
+	return 0;
+}
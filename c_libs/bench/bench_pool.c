@@ -0,0 +1,128 @@
+/* =================================
+Benchmark of the work-stealing thread pool on a recursive
+divide and conquer workload and on a parallel for
+
+usage: bench_pool [fib n] [max threads]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../include/thread_pool.h"
+
+// below this the recursion runs serially, like any real fork/join code
+#define FIB_CUTOFF 18
+#define SUM_COUNT (1 << 24)
+
+typedef struct fib_s {
+	thread_pool_t* pool;
+	int n;
+	unsigned long result;
+} fib_t;
+
+typedef struct sum_s {
+	const uint32_t* values;
+	atomic_ulong total;
+} sum_t;
+
+
+static double now_millis() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static unsigned long fib_serial(int n) {
+	return n < 2 ? n : fib_serial(n - 1) + fib_serial(n - 2);
+}
+
+static void fib_task(void* arg) {
+	fib_t* fib = arg;
+
+	if (fib->n < FIB_CUTOFF) {
+		fib->result = fib_serial(fib->n);
+		return;
+	}
+
+	fib_t left = {fib->pool, fib->n - 1, 0};
+	fib_t right = {fib->pool, fib->n - 2, 0};
+
+	tp_task_t task;
+	tp_task_init(&task, fib_task, &left);
+	thread_pool_spawn(fib->pool, &task);
+	fib_task(&right);
+	thread_pool_join(fib->pool, &task);
+
+	fib->result = left.result + right.result;
+}
+
+static void sum_body(size_t begin, size_t end, void* arg) {
+	sum_t* sum = arg;
+	unsigned long total = 0;
+
+	for (size_t i = begin; i < end; i++)
+		total += sum->values[i] % 7;
+
+	atomic_fetch_add(&sum->total, total);
+}
+
+
+int main(int argc, char *argv[]) {
+	int n = argc > 1 ? atoi(argv[1]) : 34;
+	long max_threads = argc > 2 ? atol(argv[2]) : sysconf(_SC_NPROCESSORS_ONLN);
+	if (n < 2)
+		n = 34;
+	if (max_threads < 1)
+		max_threads = 1;
+
+	uint32_t* values = malloc(SUM_COUNT * sizeof(uint32_t));
+	if (!values)
+		return 1;
+	for (size_t i = 0; i < SUM_COUNT; i++)
+		values[i] = i * 2654435761u;
+
+	double start = now_millis();
+	unsigned long expected = fib_serial(n);
+	double serial = now_millis() - start;
+
+	unsigned long expected_sum = 0;
+	start = now_millis();
+	for (size_t i = 0; i < SUM_COUNT; i++)
+		expected_sum += values[i] % 7;
+	double serial_sum = now_millis() - start;
+
+	printf("fib(%d) serial %9.2f ms, sum of %d serial %9.2f ms\n", n, serial, SUM_COUNT, serial_sum);
+
+	for (long threads = 1; threads <= max_threads; threads *= 2) {
+		thread_pool_t* pool = thread_pool_init(threads);
+		if (!pool)
+			return 1;
+
+		fib_t fib = {pool, n, 0};
+		start = now_millis();
+		thread_pool_run(pool, fib_task, &fib);
+		double fib_ms = now_millis() - start;
+
+		sum_t sum;
+		sum.values = values;
+		atomic_init(&sum.total, 0);
+		start = now_millis();
+		thread_pool_parallel_for(pool, 0, SUM_COUNT, 1 << 14, sum_body, &sum);
+		double sum_ms = now_millis() - start;
+
+		printf("%2ld threads: fib %9.2f ms (%5.2fx)%s   parallel for %9.2f ms (%5.2fx)%s\n", threads,
+			fib_ms, serial / fib_ms, fib.result == expected ? "" : " MISMATCH",
+			sum_ms, serial_sum / sum_ms, atomic_load(&sum.total) == expected_sum ? "" : " MISMATCH");
+
+		thread_pool_delete(pool);
+
+		if (threads < max_threads && threads * 2 > max_threads)
+			threads = max_threads / 2;
+	}
+
+	free(values);
+	return 0;
+}
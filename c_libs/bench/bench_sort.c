@@ -0,0 +1,103 @@
+/* =================================
+Benchmark of pdq_sort against bheap_sort, bheap2_sort and
+the libc qsort on random, sorted, reversed and few unique inputs
+
+usage: bench_sort [element count]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "../include/sort.h"
+#include "../include/binary_heap.h"
+
+typedef enum input_e {
+	INPUT_RANDOM,
+	INPUT_SORTED,
+	INPUT_REVERSED,
+	INPUT_FEW_UNIQUE,
+	INPUT_COUNT
+} input_t;
+
+static const char* input_names[INPUT_COUNT] = {"random", "sorted", "reversed", "few unique"};
+
+
+static double now_millis() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static int int_cmp(const void* a, const void* b) {
+	int x = *(const int*)a, y = *(const int*)b;
+	return (x > y) - (x < y);
+}
+
+static void fill(int* keys, int n, input_t input) {
+	for (int i = 0; i < n; i++) {
+		switch (input) {
+			case INPUT_RANDOM: keys[i] = rand(); break;
+			case INPUT_SORTED: keys[i] = i; break;
+			case INPUT_REVERSED: keys[i] = n - i; break;
+			default: keys[i] = rand() % 16; break;
+		}
+	}
+}
+
+static int is_sorted(const int* keys, int n) {
+	for (int i = 1; i < n; i++)
+		if (keys[i - 1] > keys[i])
+			return 0;
+	return 1;
+}
+
+static double time_sort(int* work, const int* keys, int n, int which) {
+	memcpy(work, keys, n * sizeof(int));
+
+	double start = now_millis();
+	switch (which) {
+		case 0: pdq_sort(work, sizeof(int), 0, n - 1, int_comparator); break;
+		case 1: bheap_sort(work, sizeof(int), 0, n - 1, int_comparator); break;
+		case 2: bheap2_sort(work, sizeof(int), 0, n - 1, int_comparator); break;
+		default: qsort(work, n, sizeof(int), int_cmp); break;
+	}
+	double elapsed = now_millis() - start;
+
+	return is_sorted(work, n) ? elapsed : -1.0;
+}
+
+
+int main(int argc, char *argv[]) {
+	int n = argc > 1 ? atoi(argv[1]) : 1000000;
+	if (n <= 1)
+		n = 1000000;
+
+	int* keys = malloc(n * sizeof(int));
+	int* work = malloc(n * sizeof(int));
+	if (!keys || !work)
+		return 1;
+
+	srand(42);
+	printf("%d elements\n", n);
+	printf("%-12s %12s %12s %12s %12s\n", "input", "pdq_sort", "bheap_sort", "bheap2_sort", "qsort");
+
+	for (int input = 0; input < INPUT_COUNT; input++) {
+		fill(keys, n, input);
+		printf("%-12s", input_names[input]);
+		for (int which = 0; which < 4; which++) {
+			double ms = time_sort(work, keys, n, which);
+			if (ms < 0)
+				printf(" %12s", "UNSORTED");
+			else
+				printf(" %9.2f ms", ms);
+		}
+		printf("\n");
+	}
+
+	free(work);
+	free(keys);
+	return 0;
+}
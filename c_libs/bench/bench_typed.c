@@ -0,0 +1,212 @@
+/* =================================
+Benchmark of the generic c_libs containers against
+the type specialized ones from typed_*.h
+
+usage: bench_typed [element count]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../include/vector.h"
+#include "../include/binary_heap.h"
+#include "../include/avl.h"
+#include "../include/queue.h"
+#include "../include/stack.h"
+#include "../include/typed_vector.h"
+#include "../include/typed_bheap.h"
+#include "../include/typed_avl.h"
+#include "../include/typed_queue.h"
+#include "../include/typed_stack.h"
+
+#define INT_LESS(a, b) ((a) < (b))
+#define INT_CMP(a, b) (((a) > (b)) - ((a) < (b)))
+
+VECTOR_DEFINE(int, int)
+BHEAP_DEFINE(int, int, INT_LESS)
+AVL_DEFINE(int, int, int, INT_CMP)
+QUEUE_DEFINE(int, int)
+STACK_DEFINE(int, int)
+
+
+static double now_millis() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static int int_cmp(const void* a, const void* b) {
+	return INT_CMP(*(const int*)a, *(const int*)b);
+}
+
+static void report(const char* name, double generic, double typed, unsigned long check_generic, unsigned long check_typed) {
+	printf("%-28s generic %9.2f ms   typed %9.2f ms   speedup %5.2fx%s\n", name, generic, typed,
+		generic / (typed > 0 ? typed : 1e-9), check_generic == check_typed ? "" : "   MISMATCH");
+}
+
+
+static void bench_vector(int* keys, int n) {
+	unsigned long sum_g = 0, sum_t = 0;
+
+	double start = now_millis();
+	vector_t* vec = vec_init(1, 0, sizeof(int));
+	for (int i = 0; i < n; i++)
+		vec_push_back(vec, &keys[i]);
+	for (int r = 0; r < 10; r++)
+		for (int i = 0; i < n; i++)
+			sum_g += *(const int*)vec_get(vec, i);
+	vec_delete(vec);
+	double generic = now_millis() - start;
+
+	start = now_millis();
+	vector_int_t* tvec = vec_int_init(1);
+	for (int i = 0; i < n; i++)
+		vec_int_push_back(tvec, keys[i]);
+	for (int r = 0; r < 10; r++)
+		for (int i = 0; i < n; i++)
+			sum_t += vec_int_get(tvec, i);
+	vec_int_delete(tvec);
+	double typed = now_millis() - start;
+
+	report("vector push + 10x scan", generic, typed, sum_g, sum_t);
+}
+
+
+static void bench_heap(int* keys, int n) {
+	unsigned long sum_g = 0, sum_t = 0;
+
+	double start = now_millis();
+	bheap_t* heap = bheap_init(n, sizeof(int), int_comparator);
+	for (int i = 0; i < n; i++)
+		bheap_insert(heap, &keys[i]);
+	for (int i = 0; i < n; i++) {
+		sum_g = sum_g * 31 + *(const int*)bheap_get_top(heap);
+		bheap_pop(heap);
+	}
+	bheap_delete(heap);
+	double generic = now_millis() - start;
+
+	start = now_millis();
+	bheap_int_t* theap = bheap_int_init(n);
+	for (int i = 0; i < n; i++)
+		bheap_int_insert(theap, keys[i]);
+	for (int i = 0; i < n; i++) {
+		sum_t = sum_t * 31 + bheap_int_get_top(theap);
+		bheap_int_pop(theap);
+	}
+	bheap_int_delete(theap);
+	double typed = now_millis() - start;
+
+	report("bheap insert + pop", generic, typed, sum_g, sum_t);
+}
+
+
+static void bench_avl(int* keys, int n) {
+	unsigned long sum_g = 0, sum_t = 0;
+
+	double start = now_millis();
+	avl_tree_t* tree = avl_tree_init(sizeof(int), sizeof(int), int_cmp);
+	for (int i = 0; i < n; i++)
+		avl_tree_insert(tree, &keys[i], &i);
+	for (int i = 0; i < n; i++)
+		sum_g += *(const int*)avl_tree_search(tree, &keys[i]);
+	avl_tree_delete(tree);
+	double generic = now_millis() - start;
+
+	start = now_millis();
+	avl_int_t* ttree = avl_int_init();
+	for (int i = 0; i < n; i++)
+		avl_int_insert(ttree, keys[i], i);
+	for (int i = 0; i < n; i++)
+		sum_t += *avl_int_search(ttree, keys[i]);
+	avl_int_delete(ttree);
+	double typed = now_millis() - start;
+
+	report("avl insert + search", generic, typed, sum_g, sum_t);
+}
+
+
+static void bench_queue(int* keys, int n) {
+	unsigned long sum_g = 0, sum_t = 0;
+
+	double start = now_millis();
+	queue_t* queue = queue_init(sizeof(int));
+	for (int i = 0; i < n; i++)
+		queue_push(queue, &keys[i]);
+	for (int i = 0; i < n; i++) {
+		sum_g += *(const int*)queue_head(queue);
+		queue_pop(queue);
+	}
+	queue_delete(queue);
+	double generic = now_millis() - start;
+
+	start = now_millis();
+	queue_int_t* tqueue = queue_int_init();
+	for (int i = 0; i < n; i++)
+		queue_int_push(tqueue, keys[i]);
+	for (int i = 0; i < n; i++) {
+		sum_t += queue_int_head(tqueue);
+		queue_int_pop(tqueue);
+	}
+	queue_int_delete(tqueue);
+	double typed = now_millis() - start;
+
+	report("queue push + pop", generic, typed, sum_g, sum_t);
+}
+
+
+static void bench_stack(int* keys, int n) {
+	unsigned long sum_g = 0, sum_t = 0;
+
+	double start = now_millis();
+	stack_t* stack = stack_init(sizeof(int));
+	for (int i = 0; i < n; i++)
+		stack_push(stack, &keys[i]);
+	for (int i = 0; i < n; i++) {
+		sum_g += *(const int*)stack_top(stack);
+		stack_pop(stack);
+	}
+	stack_delete(stack);
+	double generic = now_millis() - start;
+
+	start = now_millis();
+	stack_int_t* tstack = stack_int_init();
+	for (int i = 0; i < n; i++)
+		stack_int_push(tstack, keys[i]);
+	for (int i = 0; i < n; i++) {
+		sum_t += stack_int_top(tstack);
+		stack_int_pop(tstack);
+	}
+	stack_int_delete(tstack);
+	double typed = now_millis() - start;
+
+	report("stack push + pop", generic, typed, sum_g, sum_t);
+}
+
+
+int main(int argc, char *argv[]) {
+	int n = argc > 1 ? atoi(argv[1]) : 1000000;
+	if (n <= 0)
+		n = 1000000;
+
+	int* keys = malloc(n * sizeof(int));
+	if (!keys)
+		return 1;
+
+	srand(42);
+	for (int i = 0; i < n; i++)
+		keys[i] = rand();
+
+	printf("%d elements\n", n);
+	bench_vector(keys, n);
+	bench_heap(keys, n);
+	bench_queue(keys, n);
+	bench_stack(keys, n);
+	// last, the node allocations of the trees fragment the heap for the others
+	bench_avl(keys, n);
+
+	free(keys);
+	return 0;
+}
@@ -10,22 +10,53 @@ An AVL tree implementation in C
 #include "stdlib.h"
 #include "string.h"
 
+// an AVL tree of 2^32 nodes is at most 46 levels deep
+#define AVL_MAX_HEIGHT 64
+
+// the key and the data are stored inline after the node header,
+// at the tree's key_offset and data_offset
 typedef struct avl_node_s {
 	struct avl_node_s *left;
 	struct avl_node_s *right;
-	void* key;
-	void* data;
 	int height;
+	// nodes in the subtree rooted here, kept up to date by every rotation
+	unsigned int size;
+	char payload[];
 } avl_node_t;
 
+// nodes are carved from slabs owned by the tree, freed nodes are reused
+typedef struct avl_pool_s {
+	void* slabs;
+	// linked through their first word
+	avl_node_t* free_nodes;
+	// linked through their left pointer
+	char* next;
+	size_t remaining;
+	// nodes left to hand out from the newest slab
+	size_t slab_nodes;
+} avl_pool_t;
+
 typedef struct avl_tree_s {
 	avl_node_t* root;
 	unsigned int data_size;
 	unsigned int key_size;
 	unsigned int count;
+	unsigned int key_offset;
+	unsigned int data_offset;
+	unsigned int node_size;
+	avl_pool_t pool;
 	int (*comparation)(const void*, const void*);
 } avl_tree_t;
 
+// position in a tree, kept as the path from the root to the current node
+// any insert or erase invalidates the cursors of the tree
+typedef struct avl_cursor_s {
+	avl_tree_t* tree;
+	avl_node_t* path[AVL_MAX_HEIGHT];
+	int depth;
+	// 0 when past either end
+} avl_cursor_t;
+
 
 // initialize an empty avl tree
 avl_tree_t* avl_tree_init(unsigned int data_size, unsigned int key_size, int (*comparation)(const void*, const void*));
@@ -59,10 +90,16 @@ void avl_tree_erase(avl_tree_t* tree, void* key);
 const void* avl_tree_search(avl_tree_t* tree, void* key);
 
 
-// copy the structure of the tree
+// copy the structure of the tree, all the nodes are allocated as one block
 avl_tree_t* avl_tree_copy(avl_tree_t* tree);
 
 
+// build a balanced tree in linear time from count keys sorted in strictly increasing
+// order and their data, both arrays are copied, returns NULL if the keys are not sorted
+avl_tree_t* avl_tree_from_sorted(unsigned int data_size, unsigned int key_size, int (*comparation)(const void*, const void*),
+	const void* keys, const void* data, size_t count);
+
+
 // clears all elements from the tree
 void avl_tree_clear(avl_tree_t* tree);
 
@@ -74,4 +111,44 @@ void avl_tree_swap(avl_tree_t* a, avl_tree_t* b);
 // return the first element bigger or equal to given key
 const void* avl_lower_bound(avl_tree_t* tree, void* key);
 
+
+// number of keys smaller than key, the key itself does not have to be in the tree
+size_t avl_rank(avl_tree_t* tree, const void* key);
+
+
+// the key with index keys smaller than it, NULL if index is not below the count
+const void* avl_select(avl_tree_t* tree, size_t index);
+
+
+// move a cursor to the smallest / biggest key, returns 0 if the tree is empty
+int avl_cursor_first(avl_tree_t* tree, avl_cursor_t* cursor);
+
+int avl_cursor_last(avl_tree_t* tree, avl_cursor_t* cursor);
+
+
+// move a cursor to the first key bigger or equal to given key, returns 0 if there is none
+int avl_cursor_seek(avl_tree_t* tree, avl_cursor_t* cursor, const void* key);
+
+
+// move a cursor to the key avl_select would return, returns 0 if there is none
+int avl_cursor_select(avl_tree_t* tree, avl_cursor_t* cursor, size_t index);
+
+
+// step to the next / previous key in order, returns 0 when walking past the end
+int avl_cursor_next(avl_cursor_t* cursor);
+
+int avl_cursor_prev(avl_cursor_t* cursor);
+
+
+// key and data at the cursor, NULL when past the end
+const void* avl_cursor_key(avl_cursor_t* cursor);
+
+const void* avl_cursor_data(avl_cursor_t* cursor);
+
+
+// call callback in order for every key in [lo, hi], a NULL bound is unbounded
+// stops early when callback returns non zero, returns the number of calls
+size_t avl_range_scan(avl_tree_t* tree, const void* lo, const void* hi,
+	int (*callback)(const void* key, const void* data, void* arg), void* arg);
+
 #endif
\ No newline at end of file
@@ -29,6 +29,10 @@ typedef struct bheap_s {
 bheap_t* bheap_init(size_t capacity, size_t data_size, uint8_t (*compare)(const void*, const void*));
 
 
+// creates a heap holding a copy of count elements of array, built in linear time
+bheap_t* bheap_from_array(const void* array, size_t count, size_t data_size, uint8_t (*compare)(const void*, const void*));
+
+
 // deletes a binary heap from memory
 clib_exit_code_t bheap_delete(bheap_t* heap);
 
@@ -53,11 +57,19 @@ clib_exit_code_t bheap_insert(bheap_t* heap, void* data);
 clib_exit_code_t bheap_pop(bheap_t* heap);
 
 
+// inserts data and removes the top into out in one sift, data must not be an element of the heap
+clib_exit_code_t bheap_push_pop(bheap_t* heap, const void* data, void* out);
+
+
+// replaces the top of a non empty heap with data in one sift
+clib_exit_code_t bheap_replace_top(bheap_t* heap, const void* data);
+
+
 // get the element at the top of the heap
 const void* bheap_get_top(bheap_t* heap);
 
 
-// sorts an array of data using heap sort
+// sorts an array of data using heap sort, pdq_sort from sort.h is faster for plain arrays
 clib_exit_code_t bheap_sort(void* array, size_t elem_size, size_t begin, size_t end, uint8_t (*compare)(const void*, const void*));
 
 
@@ -105,7 +117,7 @@ clib_exit_code_t bheap2_pop(bheap2_t* heap);
 void* const	bheap2_get_top(bheap2_t* heap);
 
 
-// sorts an array of data using heap sort
+// sorts an array of data using heap sort, pdq_sort from sort.h is faster for plain arrays
 clib_exit_code_t bheap2_sort(void* array, size_t elem_size, size_t begin, size_t end, uint8_t (*compare)(const void*, const void*));
 
 #endif
@@ -0,0 +1,100 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+A B+tree implementation in C
+*/
+
+#ifndef CBTREE_H
+#define CBTREE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "utils.h"
+
+// target size of a node, a few cache lines so a level costs a few misses
+#define BTREE_NODE_BYTES 256
+#define BTREE_MAX_HEIGHT 32
+
+// inner nodes hold count keys and count + 1 children, leaves hold count keys
+// and their data and are linked in key order; the arrays follow the header
+// at the tree's offsets
+typedef struct btree_node_s {
+	struct btree_node_s* next;
+	// next leaf, NULL for inner nodes
+	unsigned short count;
+	unsigned char leaf;
+	_Alignas(sizeof(void*)) char payload[];
+} btree_node_t;
+
+typedef struct btree_s {
+	btree_node_t* root;
+	unsigned int data_size;
+	unsigned int key_size;
+	unsigned int count;
+	unsigned int height;
+
+	// fanout and layout, computed from the key and data sizes
+	unsigned int inner_max;
+	unsigned int leaf_max;
+	unsigned int inner_keys;
+	unsigned int leaf_keys;
+	unsigned int leaf_data;
+	unsigned int inner_size;
+	unsigned int leaf_size;
+
+	// room for one overfull node while splitting
+	void* scratch;
+	int (*comparation)(const void*, const void*);
+} btree_t;
+
+
+// initialize an empty B+tree, comparation has the same meaning as for avl_tree_t
+btree_t* btree_init(unsigned int data_size, unsigned int key_size, int (*comparation)(const void*, const void*));
+
+
+// count the number of elements in the tree
+size_t btree_count(btree_t* tree);
+
+
+// empty the memory of a tree
+void btree_delete(btree_t* tree);
+
+
+// insert an element in the tree, replaces the data of an existing key
+clib_exit_code_t btree_insert(btree_t* tree, void* key, void* data);
+
+
+// erase a specific key from the tree
+void btree_erase(btree_t* tree, void* key);
+
+
+// search a specific key in the tree
+const void* btree_search(btree_t* tree, void* key);
+
+
+// return the first key bigger or equal to given key
+const void* btree_lower_bound(btree_t* tree, void* key);
+
+
+// get the minimum / maximum value key in the tree
+const void* btree_min_key(btree_t* tree);
+
+const void* btree_max_key(btree_t* tree);
+
+
+// clears all elements from the tree
+void btree_clear(btree_t* tree);
+
+
+// swaps all the data between two different trees
+void btree_swap(btree_t* a, btree_t* b);
+
+
+// call callback in order for every key in [lo, hi], a NULL bound is unbounded
+// walks the linked leaves, stops early when callback returns non zero, returns the number of calls
+size_t btree_range_scan(btree_t* tree, const void* lo, const void* hi,
+	int (*callback)(const void* key, const void* data, void* arg), void* arg);
+
+#endif
@@ -0,0 +1,84 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+A d-ary heap implementation in C with cache line aligned children
+*/
+
+#ifndef CDARY_HEAP_H
+#define CDARY_HEAP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "utils.h"
+
+#define DHEAP_CACHE_LINE 64
+
+// every node has arity children stored next to each other, elements sit arity - 1
+// slots into a cache line aligned buffer so each group of children starts at a
+// multiple of arity * data_size, a group never straddles a cache line when that
+// size divides 64 and fills whole lines when it is a multiple of 64,
+// the first padding slot is scratch space for sifting
+typedef struct dheap_s {
+	size_t capacity;
+	size_t count;
+	size_t data_size;
+	unsigned int arity;
+	unsigned int arity_log;
+	char* buffer;
+	char* data;
+	uint8_t	(*compare)(const void*, const void*);
+} dheap_t;
+
+
+// creates a heap ready to use, arity is rounded up to a power of two between 2 and 64,
+// 4 or 8 usually fit best, compare(a, b) is true when a goes after b like in bheap_t
+dheap_t* dheap_init(size_t capacity, size_t data_size, unsigned int arity, uint8_t (*compare)(const void*, const void*));
+
+
+// creates a heap holding a copy of count elements of array, built in linear time
+dheap_t* dheap_from_array(const void* array, size_t count, size_t data_size, unsigned int arity,
+	uint8_t (*compare)(const void*, const void*));
+
+
+// deletes a heap from memory
+clib_exit_code_t dheap_delete(dheap_t* heap);
+
+
+// clears all the data from a heap, the memory is kept
+clib_exit_code_t dheap_clear(dheap_t* heap);
+
+
+// swaps two heaps
+clib_exit_code_t dheap_swap(dheap_t* heap_a, dheap_t* heap_b);
+
+
+// copy a heap
+dheap_t* dheap_copy(dheap_t* heap);
+
+
+// number of elements in the heap
+size_t dheap_count(dheap_t* heap);
+
+
+// inserts an element in the heap
+clib_exit_code_t dheap_insert(dheap_t* heap, const void* data);
+
+
+// remove the top of the heap
+clib_exit_code_t dheap_pop(dheap_t* heap);
+
+
+// inserts data and removes the top into out in one sift, data must not be an element of the heap
+clib_exit_code_t dheap_push_pop(dheap_t* heap, const void* data, void* out);
+
+
+// replaces the top of a non empty heap with data in one sift
+clib_exit_code_t dheap_replace_top(dheap_t* heap, const void* data);
+
+
+// get the element at the top of the heap
+const void* dheap_get_top(dheap_t* heap);
+
+#endif
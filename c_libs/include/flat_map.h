@@ -0,0 +1,86 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+A sorted flat map implementation in C
+*/
+
+#ifndef CFLAT_MAP_H
+#define CFLAT_MAP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils.h"
+
+// keys and data live in two parallel arrays sorted by key,
+// lookups are binary searches over the contiguous key array
+typedef struct flat_map_s {
+	void* keys;
+	void* data;
+	size_t count;
+	size_t capacity;
+	unsigned int data_size;
+	unsigned int key_size;
+	int (*comparation)(const void*, const void*);
+} flat_map_t;
+
+
+// initialize an empty flat map, comparation has the same meaning as for avl_tree_t
+flat_map_t* flat_map_init(unsigned int data_size, unsigned int key_size, int (*comparation)(const void*, const void*));
+
+
+// empty the memory of a flat map
+void flat_map_delete(flat_map_t* map);
+
+
+// count the number of elements in the map
+size_t flat_map_count(flat_map_t* map);
+
+
+// replace the content of the map with count unsorted key / data pairs
+// for repeated keys the last pair wins, like repeated inserts
+clib_exit_code_t flat_map_build(flat_map_t* map, const void* keys, const void* data, size_t count);
+
+
+// insert an element in the map, O(n) because of the shifting
+clib_exit_code_t flat_map_insert(flat_map_t* map, void* key, void* data);
+
+
+// erase a specific key from the map
+void flat_map_erase(flat_map_t* map, void* key);
+
+
+// search a specific key in the map
+const void* flat_map_search(flat_map_t* map, void* key);
+
+
+// return the first key bigger or equal to given key
+const void* flat_map_lower_bound(flat_map_t* map, void* key);
+
+
+// get the minimum value key in the map
+const void* flat_map_min_key(flat_map_t* map);
+
+
+// get the maximum value key in the map
+const void* flat_map_max_key(flat_map_t* map);
+
+
+// get the key / data at a position in key order
+const void* flat_map_key_at(flat_map_t* map, size_t index);
+
+const void* flat_map_data_at(flat_map_t* map, size_t index);
+
+
+// copy the content of the map
+flat_map_t* flat_map_copy(flat_map_t* map);
+
+
+// clears all elements from the map
+void flat_map_clear(flat_map_t* map);
+
+
+// swaps all the data between two different maps
+void flat_map_swap(flat_map_t* a, flat_map_t* b);
+
+#endif
@@ -0,0 +1,95 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+An addressable heap implementation in C, elements are reached through handles
+*/
+
+#ifndef CINDEXED_HEAP_H
+#define CINDEXED_HEAP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "utils.h"
+
+#define IHEAP_NONE ((iheap_handle_t)-1)
+
+// stays valid until its element is popped or erased, then it may be handed out again
+typedef size_t iheap_handle_t;
+
+// a 4-ary heap of handles, the elements stay in place in data and position
+// tells where each handle sits in the heap so it can be found and moved
+typedef struct iheap_s {
+	size_t count;
+	size_t capacity;
+	size_t data_size;
+	// handles handed out so far, free ones included
+	size_t used;
+	iheap_handle_t* heap;
+	// IHEAP_NONE for handles not in the heap
+	size_t* position;
+	char* data;
+	// released handles, reused before new ones
+	iheap_handle_t* free_handles;
+	size_t free_count;
+	uint8_t	(*compare)(const void*, const void*);
+} iheap_t;
+
+
+// creates a heap ready to use, compare(a, b) is true when a goes after b like in bheap_t
+iheap_t* iheap_init(size_t capacity, size_t data_size, uint8_t (*compare)(const void*, const void*));
+
+
+// deletes a heap from memory
+clib_exit_code_t iheap_delete(iheap_t* heap);
+
+
+// clears all the data from a heap, every handle becomes invalid
+clib_exit_code_t iheap_clear(iheap_t* heap);
+
+
+// number of elements in the heap
+size_t iheap_count(iheap_t* heap);
+
+
+// inserts an element, its handle goes to handle when it is not NULL
+clib_exit_code_t iheap_push(iheap_t* heap, const void* data, iheap_handle_t* handle);
+
+
+// remove the top of the heap
+clib_exit_code_t iheap_pop(iheap_t* heap);
+
+
+// get the element / handle at the top of the heap, NULL / IHEAP_NONE when empty
+const void* iheap_get_top(iheap_t* heap);
+
+iheap_handle_t iheap_top_handle(iheap_t* heap);
+
+
+// 1 if handle refers to an element in the heap
+int iheap_contains(iheap_t* heap, iheap_handle_t handle);
+
+
+// the element of a handle, NULL if it is not in the heap
+const void* iheap_get(iheap_t* heap, iheap_handle_t handle);
+
+
+// replace the element of a handle with data, moving it either way
+clib_exit_code_t iheap_update(iheap_t* heap, iheap_handle_t handle, const void* data);
+
+
+// replace the element of a handle with data that goes before it or ties,
+// UNSAFE without any change if data would go after it
+clib_exit_code_t iheap_decrease_key(iheap_t* heap, iheap_handle_t handle, const void* data);
+
+
+// replace the element of a handle with data that goes after it or ties,
+// UNSAFE without any change if data would go before it
+clib_exit_code_t iheap_increase_key(iheap_t* heap, iheap_handle_t handle, const void* data);
+
+
+// remove the element of a handle from the heap
+clib_exit_code_t iheap_erase(iheap_t* heap, iheap_handle_t handle);
+
+#endif
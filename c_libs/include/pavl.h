@@ -0,0 +1,95 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+A persistent AVL tree in C, copies share their nodes
+*/
+
+
+#ifndef CPAVL_H
+#define CPAVL_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include "utils.h"
+
+// an AVL tree of 2^32 nodes is at most 46 levels deep
+#define PAVL_MAX_HEIGHT 64
+
+// nodes are shared between every tree copied from the same one and are
+// freed when the last tree or parent node referring to them lets go,
+// key and data are stored inline at the tree's key_offset and data_offset
+typedef struct pavl_node_s {
+	struct pavl_node_s *left;
+	struct pavl_node_s *right;
+	atomic_uint refs;
+	int height;
+	char payload[];
+} pavl_node_t;
+
+// an update copies the shared nodes on the path it walks and changes the
+// nodes only this tree refers to in place, the other copies never see it
+typedef struct pavl_tree_s {
+	pavl_node_t* root;
+	unsigned int data_size;
+	unsigned int key_size;
+	unsigned int count;
+	unsigned int key_offset;
+	unsigned int data_offset;
+	unsigned int node_size;
+	int (*comparation)(const void*, const void*);
+} pavl_tree_t;
+
+
+// initialize an empty persistent avl tree
+pavl_tree_t* pavl_tree_init(unsigned int data_size, unsigned int key_size, int (*comparation)(const void*, const void*));
+
+
+// count the number of elements in the tree
+int pavl_tree_count(const pavl_tree_t* tree);
+
+
+// drop the tree, nodes still used by other copies stay alive
+void pavl_tree_delete(pavl_tree_t* tree);
+
+
+// snapshot of the tree in constant time, both trees can be changed independently
+pavl_tree_t* pavl_tree_copy(pavl_tree_t* tree);
+
+
+// insert an element or replace the data of an existing key
+clib_exit_code_t pavl_tree_insert(pavl_tree_t* tree, const void* key, const void* data);
+
+
+// erase a specific key from the tree
+clib_exit_code_t pavl_tree_erase(pavl_tree_t* tree, const void* key);
+
+
+// search a specific key in the tree
+const void* pavl_tree_search(const pavl_tree_t* tree, const void* key);
+
+
+// get the minimum / maximum value key in the tree
+const void* pavl_min_key(const pavl_tree_t* tree);
+
+const void* pavl_max_key(const pavl_tree_t* tree);
+
+
+// return the first element bigger or equal to given key
+const void* pavl_lower_bound(const pavl_tree_t* tree, const void* key);
+
+
+// clears all elements from the tree
+void pavl_tree_clear(pavl_tree_t* tree);
+
+
+// swaps all the data between two different trees
+void pavl_tree_swap(pavl_tree_t* a, pavl_tree_t* b);
+
+
+// call callback in order for every key in [lo, hi], a NULL bound is unbounded
+// stops early when callback returns non zero, returns the number of calls
+size_t pavl_range_scan(const pavl_tree_t* tree, const void* lo, const void* hi,
+	int (*callback)(const void* key, const void* data, void* arg), void* arg);
+
+#endif
@@ -12,16 +12,13 @@ A queue implementation in C
 
 #include "utils.h"
 
-typedef struct queue_node_s {
-	struct queue_node_s* next;
-	void* data;
-} queue_node_t;
-
+// ring buffer, capacity is a power of two so positions wrap with a mask
 typedef struct queue_s {
 	size_t data_size;
 	size_t count;
-	queue_node_t* head;
-	queue_node_t* tail;
+	size_t capacity;
+	size_t head;
+	void* data;
 } queue_t;
 
 
@@ -61,4 +58,16 @@ clib_exit_code_t queue_pop(queue_t* queue);
 const void* queue_head(queue_t* queue);
 
 
+// make room for at least capacity elements without further reallocations
+clib_exit_code_t queue_reserve(queue_t* queue, size_t capacity);
+
+
+// push count contiguous elements on the queue tail
+clib_exit_code_t queue_push_n(queue_t* queue, const void* data, size_t count);
+
+
+// pop up to count elements from the head into out (if not NULL), returns how many were popped
+size_t queue_pop_n(queue_t* queue, void* out, size_t count);
+
+
 #endif
\ No newline at end of file
@@ -0,0 +1,62 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+A radix heap implementation in C for monotone integer priorities
+*/
+
+#ifndef CRADIX_HEAP_H
+#define CRADIX_HEAP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "utils.h"
+#include "vector.h"
+
+#define RADIX_HEAP_BUCKETS 65
+
+// a min heap of uint64_t keys that never go below the last popped key, as in
+// shortest path searches, bucket i holds the keys whose highest bit differing
+// from that key is bit i - 1, bucket 0 the keys equal to it, a key only ever
+// moves to lower buckets so each push costs O(log of the key range) overall
+typedef struct radix_heap_s {
+	uint64_t last;
+	size_t count;
+	size_t data_size;
+	// the key followed by the data, padded to keep keys aligned
+	size_t entry_size;
+	vector_t* buckets[RADIX_HEAP_BUCKETS];
+} radix_heap_t;
+
+
+// creates an empty heap of elements carrying data_size bytes next to the key
+radix_heap_t* radix_heap_init(size_t data_size);
+
+
+// deletes a heap from memory
+clib_exit_code_t radix_heap_delete(radix_heap_t* heap);
+
+
+// clears all the data from a heap, keys may start from 0 again
+clib_exit_code_t radix_heap_clear(radix_heap_t* heap);
+
+
+// number of elements in the heap
+size_t radix_heap_count(radix_heap_t* heap);
+
+
+// inserts a key with its data, OUT_OF_BOUNDS if the key is below the last popped one
+clib_exit_code_t radix_heap_push(radix_heap_t* heap, uint64_t key, const void* data);
+
+
+// the data of the smallest key, its key goes to key when not NULL, NULL when empty,
+// a peek does not change which keys can be pushed
+const void* radix_heap_top(radix_heap_t* heap, uint64_t* key);
+
+
+// removes the smallest key, copying it and its data out when key / data are not NULL,
+// OUT_OF_BOUNDS when empty
+clib_exit_code_t radix_heap_pop(radix_heap_t* heap, uint64_t* key, void* data);
+
+#endif
@@ -0,0 +1,97 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+A concurrent read-mostly ordered map in C
+*/
+
+#ifndef CRCU_MAP_H
+#define CRCU_MAP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "utils.h"
+#include "queue.h"
+#include "pavl.h"
+
+#define RCU_MAP_CACHE_LINE 64
+
+// readers publish the epoch they entered with, 0 outside of a read section,
+// each on its own cache line so readers never share one
+typedef struct rcu_map_reader_s {
+	_Alignas(RCU_MAP_CACHE_LINE) atomic_uint_fast64_t epoch;
+	atomic_int used;
+} rcu_map_reader_t;
+
+// readers never lock, they read whatever version is current when they enter,
+// writers are serialized, change a copy of the current version and swap it in,
+// a replaced version is freed once no reader that may have seen it is left
+typedef struct rcu_map_s {
+	_Alignas(RCU_MAP_CACHE_LINE) _Atomic(pavl_tree_t*) current;
+	atomic_uint_fast64_t epoch;
+
+	_Alignas(RCU_MAP_CACHE_LINE) pthread_mutex_t write_lock;
+	// replaced versions waiting for their readers, in epoch order
+	queue_t* retired;
+	atomic_uint count;
+
+	size_t max_readers;
+	rcu_map_reader_t* readers;
+} rcu_map_t;
+
+
+// initialize an empty map that up to max_readers threads can read at once
+rcu_map_t* rcu_map_init(unsigned int data_size, unsigned int key_size, int (*comparation)(const void*, const void*),
+	size_t max_readers);
+
+
+// free the map, no thread may be reading or writing it anymore
+void rcu_map_delete(rcu_map_t* map);
+
+
+// claim a reader slot for the calling thread, NULL if all of them are taken
+rcu_map_reader_t* rcu_map_reader_register(rcu_map_t* map);
+
+void rcu_map_reader_unregister(rcu_map_t* map, rcu_map_reader_t* reader);
+
+
+// read sections, they do not nest and keep every version they see alive
+// so they should be short, a writer can not free anything while one is open
+void rcu_map_read_lock(rcu_map_t* map, rcu_map_reader_t* reader);
+
+void rcu_map_read_unlock(rcu_map_reader_t* reader);
+
+
+// the current version, only valid until the read section ends
+const pavl_tree_t* rcu_map_version(rcu_map_t* map);
+
+
+// copy the data of key to data, returns 1 if found
+int rcu_map_search(rcu_map_t* map, rcu_map_reader_t* reader, const void* key, void* data);
+
+
+// a private copy of the current version that outlives the read section,
+// for long scans, release it with pavl_tree_delete
+pavl_tree_t* rcu_map_snapshot(rcu_map_t* map, rcu_map_reader_t* reader);
+
+
+// number of elements in the current version
+int rcu_map_count(rcu_map_t* map);
+
+
+// insert an element or replace the data of an existing key
+clib_exit_code_t rcu_map_insert(rcu_map_t* map, const void* key, const void* data);
+
+
+// erase a specific key from the map
+clib_exit_code_t rcu_map_erase(rcu_map_t* map, const void* key);
+
+
+// apply several changes as one new version, readers see all of them or none,
+// the version is dropped when update does not return OK
+clib_exit_code_t rcu_map_update(rcu_map_t* map, clib_exit_code_t (*update)(pavl_tree_t* draft, void* arg), void* arg);
+
+#endif
@@ -0,0 +1,115 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+Small buffer optimized vector generator in C
+*/
+
+#ifndef CSMALL_VECTOR_H
+#define CSMALL_VECTOR_H
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils.h"
+
+// SMALL_VECTOR_DEFINE(name, T, N) emits svec_name_t, a vector of T keeping up
+// to N elements inline in the struct and moving them to the heap only when it
+// grows past N, with its static inline operations svec_name_*.
+//
+// The vector is meant to be embedded by value in the object owning it, so the
+// common short case needs no allocation and shares the owner cache lines.
+// It can be moved with a plain struct copy, the old copy must not be used.
+//
+//     SMALL_VECTOR_DEFINE(child, node_t*, 4)
+//     struct node_s { svec_child_t children; };
+//     svec_child_init(&node->children);
+
+#define SMALL_VECTOR_DEFINE(name, T, N)                                                     \
+                                                                                            \
+typedef struct svec_##name##_s {                                                            \
+	size_t count;                                                                           \
+	size_t capacity;                                                                        \
+	/* storage is inline while capacity == N */                                             \
+	union {                                                                                 \
+		T inline_data[N];                                                                   \
+		T* heap_data;                                                                       \
+	} storage;                                                                              \
+} svec_##name##_t;                                                                          \
+                                                                                            \
+/* initialize an empty vector using its inline storage */                                   \
+static inline void svec_##name##_init(svec_##name##_t* vec) {                               \
+	vec->count = 0;                                                                         \
+	vec->capacity = N;                                                                      \
+}                                                                                           \
+                                                                                            \
+/* free the heap storage, the vector is left empty */                                       \
+static inline void svec_##name##_free(svec_##name##_t* vec) {                               \
+	if(vec->capacity > N)                                                                   \
+		free(vec->storage.heap_data);                                                       \
+	svec_##name##_init(vec);                                                                \
+}                                                                                           \
+                                                                                            \
+/* pointer to the contiguous elements */                                                    \
+static inline T* svec_##name##_data(svec_##name##_t* vec) {                                 \
+	return vec->capacity > N ? vec->storage.heap_data : vec->storage.inline_data;           \
+}                                                                                           \
+                                                                                            \
+/* make sure the vector can hold capacity elements */                                       \
+static inline clib_exit_code_t svec_##name##_reserve(svec_##name##_t* vec, size_t capacity) { \
+	if(capacity <= vec->capacity)                                                           \
+		return OK;                                                                          \
+	if(capacity < 2 * vec->capacity)                                                        \
+		capacity = 2 * vec->capacity;                                                       \
+	T* data;                                                                                \
+	if(vec->capacity > N) {                                                                 \
+		data = realloc(vec->storage.heap_data, capacity * sizeof(T));                       \
+		if(data == NULL)                                                                    \
+			return OUT_OF_MEM;                                                              \
+	} else {                                                                                \
+		data = malloc(capacity * sizeof(T));                                                \
+		if(data == NULL)                                                                    \
+			return OUT_OF_MEM;                                                              \
+		memcpy(data, vec->storage.inline_data, vec->count * sizeof(T));                     \
+	}                                                                                       \
+	vec->storage.heap_data = data;                                                          \
+	vec->capacity = capacity;                                                               \
+	return OK;                                                                              \
+}                                                                                           \
+                                                                                            \
+/* insert a new element at the end of the vector */                                         \
+static inline clib_exit_code_t svec_##name##_push_back(svec_##name##_t* vec, T value) {     \
+	if(vec->count == vec->capacity) {                                                       \
+		clib_exit_code_t err = svec_##name##_reserve(vec, vec->count + 1);                  \
+		if(err != OK)                                                                       \
+			return err;                                                                     \
+	}                                                                                       \
+	svec_##name##_data(vec)[vec->count++] = value;                                          \
+	return OK;                                                                              \
+}                                                                                           \
+                                                                                            \
+/* remove the last element in the vector */                                                 \
+static inline void svec_##name##_remove_back(svec_##name##_t* vec) {                        \
+	if(vec->count)                                                                          \
+		vec->count--;                                                                       \
+}                                                                                           \
+                                                                                            \
+/* get the element at given index, index must be in bounds */                               \
+static inline T svec_##name##_get(svec_##name##_t* vec, size_t index) {                     \
+	return svec_##name##_data(vec)[index];                                                  \
+}                                                                                           \
+                                                                                            \
+/* set the element at given index, index must be in bounds */                               \
+static inline void svec_##name##_set(svec_##name##_t* vec, size_t index, T value) {         \
+	svec_##name##_data(vec)[index] = value;                                                 \
+}                                                                                           \
+                                                                                            \
+/* clear all elements, keeps the capacity */                                                \
+static inline void svec_##name##_clear(svec_##name##_t* vec) {                              \
+	vec->count = 0;                                                                         \
+}                                                                                           \
+                                                                                            \
+/* get the count of a vector */                                                             \
+static inline size_t svec_##name##_count(const svec_##name##_t* vec) {                      \
+	return vec->count;                                                                      \
+}
+
+#endif
@@ -0,0 +1,22 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+Pattern-defeating quicksort in C
+*/
+
+#ifndef CSORT_H
+#define CSORT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "utils.h"
+
+// sorts array[begin..end] in place with pattern-defeating quicksort
+// same interface as bheap_sort: compare(a, b) is true when a must come after b
+// O(n log n) worst case, linear on sorted, reversed and few distinct inputs, not stable
+clib_exit_code_t pdq_sort(void* array, size_t elem_size, size_t begin, size_t end, uint8_t (*compare)(const void*, const void*));
+
+#endif
@@ -0,0 +1,70 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+A lock-free single producer / single consumer ring queue in C
+*/
+
+#ifndef CSPSC_RING_H
+#define CSPSC_RING_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "utils.h"
+
+#define SPSC_CACHE_LINE 64
+
+// head is only written by the consumer and tail only by the producer, each on its
+// own cache line together with that side's cached copy of the other index
+typedef struct spsc_ring_s {
+	_Alignas(SPSC_CACHE_LINE) atomic_size_t head;
+	size_t tail_cache;
+
+	_Alignas(SPSC_CACHE_LINE) atomic_size_t tail;
+	size_t head_cache;
+
+	_Alignas(SPSC_CACHE_LINE) size_t capacity;
+	size_t data_size;
+	atomic_int closed;
+	char* data;
+} spsc_ring_t;
+
+
+// initialize a ring, capacity is rounded up to a power of two
+spsc_ring_t* spsc_ring_init(size_t capacity, size_t data_size);
+
+
+// delete a ring, no thread may use it anymore
+clib_exit_code_t spsc_ring_delete(spsc_ring_t* ring);
+
+
+// producer: push one element, returns 1 on success, 0 if the ring is full
+uint8_t spsc_ring_push(spsc_ring_t* ring, const void* data);
+
+
+// producer: push up to count elements, returns how many were pushed
+size_t spsc_ring_push_n(spsc_ring_t* ring, const void* data, size_t count);
+
+
+// consumer: pop one element into out, returns 1 on success, 0 if the ring is empty
+uint8_t spsc_ring_pop(spsc_ring_t* ring, void* out);
+
+
+// consumer: pop up to count elements into out, returns how many were popped
+size_t spsc_ring_pop_n(spsc_ring_t* ring, void* out, size_t count);
+
+
+// producer: no more elements will be pushed
+void spsc_ring_close(spsc_ring_t* ring);
+
+
+// consumer: 1 once the producer closed the ring and every element was popped
+uint8_t spsc_ring_drained(spsc_ring_t* ring);
+
+
+// approximate number of elements, exact when called from either side
+size_t spsc_ring_count(spsc_ring_t* ring);
+
+#endif
@@ -4,16 +4,23 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 
 #include "utils.h"
 
-typedef struct stack_node_s {
-	void* data;
-	struct stack_node_s* next;
-} stack_node_t;
+// elements are stored contiguously in chunks of growing capacity,
+// each chunk points to the one below it
+typedef struct stack_chunk_s {
+	struct stack_chunk_s* prev;
+	size_t capacity;
+	size_t used;
+	_Alignas(max_align_t) char data[];
+} stack_chunk_t;
 
 typedef struct stack_s {
-	stack_node_t* root;
+	stack_chunk_t* top;
+	// last emptied chunk, kept to avoid malloc/free when push and pop alternate on a chunk boundary
+	stack_chunk_t* spare;
 	size_t data_size;
 	size_t count;
 } stack_t;
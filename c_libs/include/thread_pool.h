@@ -0,0 +1,103 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+A work-stealing thread pool in C
+*/
+
+#ifndef CTHREAD_POOL_H
+#define CTHREAD_POOL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "utils.h"
+#include "queue.h"
+
+#define TP_CACHE_LINE 64
+
+// a unit of work, owned by the caller of thread_pool_spawn until it is joined,
+// so it can live on the stack of the forking function
+typedef struct tp_task_s {
+	void (*function)(void* arg);
+	void* arg;
+	atomic_int done;
+} tp_task_t;
+
+typedef struct tp_array_s {
+	size_t size;
+	struct tp_array_s* retired;
+	// older buffer replaced by this one, freed with the pool since thieves may still read it
+	_Atomic(tp_task_t*) tasks[];
+} tp_array_t;
+
+// Chase-Lev deque: the owner pushes and takes at the bottom, thieves steal from the top
+typedef struct tp_deque_s {
+	_Alignas(TP_CACHE_LINE) atomic_llong top;
+	_Alignas(TP_CACHE_LINE) atomic_llong bottom;
+	_Atomic(tp_array_t*) array;
+} tp_deque_t;
+
+typedef struct thread_pool_s thread_pool_t;
+
+typedef struct tp_worker_s {
+	tp_deque_t deque;
+	thread_pool_t* pool;
+	pthread_t thread;
+	uint64_t seed;
+	// state of the victim picking
+} tp_worker_t;
+
+struct thread_pool_s {
+	tp_worker_t* workers;
+	size_t count;
+
+	// tasks spawned by threads outside the pool
+	queue_t* inject;
+	pthread_mutex_t inject_lock;
+	atomic_size_t injected;
+
+	// idle workers sleep until something is queued
+	atomic_size_t queued;
+	atomic_size_t sleepers;
+	pthread_mutex_t sleep_lock;
+	pthread_cond_t wake;
+	atomic_int stop;
+};
+
+
+// start a pool, threads == 0 uses one worker per online core
+thread_pool_t* thread_pool_init(size_t threads);
+
+
+// stop the workers and free the pool, every spawned task must have been joined
+clib_exit_code_t thread_pool_delete(thread_pool_t* pool);
+
+
+// number of worker threads
+size_t thread_pool_threads(thread_pool_t* pool);
+
+
+// prepare a task calling function(arg)
+void tp_task_init(tp_task_t* task, void (*function)(void*), void* arg);
+
+
+// fork: queue a task, it may run on any worker until it is joined
+clib_exit_code_t thread_pool_spawn(thread_pool_t* pool, tp_task_t* task);
+
+
+// join: wait for a spawned task, running other queued tasks meanwhile
+void thread_pool_join(thread_pool_t* pool, tp_task_t* task);
+
+
+// run function(arg) inside the pool and wait for it, so it can fork and join
+clib_exit_code_t thread_pool_run(thread_pool_t* pool, void (*function)(void*), void* arg);
+
+
+// call body on subranges of [begin, end) of at most grain elements, in parallel
+clib_exit_code_t thread_pool_parallel_for(thread_pool_t* pool, size_t begin, size_t end, size_t grain,
+	void (*body)(size_t begin, size_t end, void* arg), void* arg);
+
+#endif
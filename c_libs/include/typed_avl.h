@@ -0,0 +1,289 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+Type specialized AVL tree generator in C
+*/
+
+#ifndef CTYPED_AVL_H
+#define CTYPED_AVL_H
+
+#include <stdlib.h>
+
+#include "utils.h"
+
+// an AVL tree of 2^32 nodes is at most 46 levels deep
+#define TYPED_AVL_MAX_HEIGHT 64
+#define TYPED_AVL_SLAB_MIN 64
+#define TYPED_AVL_SLAB_MAX 4096
+
+// AVL_DEFINE(name, K, V, cmp) emits avl_name_t, an AVL tree mapping keys of
+// type K to values of type V, and its static inline operations avl_name_*.
+// Keys and values live inside the node, and cmp(a, b) is called directly on
+// two keys, returning < 0, 0 or > 0 like the comparation of avl_tree_t.
+// Like avl_tree_t, nodes come from slabs owned by the tree and updates walk
+// a path instead of recursing.
+//
+//     #define I64_CMP(a, b) (((a) > (b)) - ((a) < (b)))
+//     AVL_DEFINE(i64, int64_t, double, I64_CMP)
+
+#define AVL_DEFINE(name, K, V, cmp)                                                         \
+                                                                                            \
+typedef struct avl_##name##_node_s {                                                        \
+	struct avl_##name##_node_s* left;                                                       \
+	struct avl_##name##_node_s* right;                                                      \
+	int height;                                                                             \
+	K key;                                                                                  \
+	V data;                                                                                 \
+} avl_##name##_node_t;                                                                      \
+                                                                                            \
+/* slabs are chained through prev, free nodes through their left pointer */                 \
+typedef struct avl_##name##_slab_s {                                                        \
+	struct avl_##name##_slab_s* prev;                                                       \
+	avl_##name##_node_t nodes[];                                                            \
+} avl_##name##_slab_t;                                                                      \
+                                                                                            \
+typedef struct avl_##name##_s {                                                             \
+	avl_##name##_node_t* root;                                                              \
+	size_t count;                                                                           \
+	avl_##name##_slab_t* slabs;                                                             \
+	avl_##name##_node_t* free_nodes;                                                        \
+	/* nodes handed out from the newest slab and its capacity */                            \
+	size_t used;                                                                            \
+	size_t slab_nodes;                                                                      \
+} avl_##name##_t;                                                                           \
+                                                                                            \
+static inline avl_##name##_node_t* _avl_##name##_alloc(avl_##name##_t* tree) {              \
+	avl_##name##_node_t* node = tree->free_nodes;                                           \
+	if(node) {                                                                              \
+		tree->free_nodes = node->left;                                                      \
+		return node;                                                                        \
+	}                                                                                       \
+	if(tree->slabs == NULL || tree->used == tree->slab_nodes) {                             \
+		size_t nodes = tree->slab_nodes ? tree->slab_nodes * 2 : TYPED_AVL_SLAB_MIN;        \
+		if(nodes > TYPED_AVL_SLAB_MAX)                                                      \
+			nodes = TYPED_AVL_SLAB_MAX;                                                     \
+		size_t size = sizeof(avl_##name##_slab_t) + nodes * sizeof(avl_##name##_node_t);    \
+		avl_##name##_slab_t* slab = malloc(size);                                           \
+		if(slab == NULL)                                                                    \
+			return NULL;                                                                    \
+		slab->prev = tree->slabs;                                                           \
+		tree->slabs = slab;                                                                 \
+		tree->slab_nodes = nodes;                                                           \
+		tree->used = 0;                                                                     \
+	}                                                                                       \
+	return &tree->slabs->nodes[tree->used++];                                               \
+}                                                                                           \
+                                                                                            \
+static inline void _avl_##name##_free(avl_##name##_t* tree, avl_##name##_node_t* node) {    \
+	node->left = tree->free_nodes;                                                          \
+	tree->free_nodes = node;                                                                \
+}                                                                                           \
+                                                                                            \
+static inline void _avl_##name##_release(avl_##name##_t* tree) {                            \
+	while(tree->slabs) {                                                                    \
+		avl_##name##_slab_t* prev = tree->slabs->prev;                                      \
+		free(tree->slabs);                                                                  \
+		tree->slabs = prev;                                                                 \
+	}                                                                                       \
+	tree->free_nodes = NULL;                                                                \
+	tree->used = 0;                                                                         \
+	tree->slab_nodes = 0;                                                                   \
+}                                                                                           \
+                                                                                            \
+static inline int _avl_##name##_height(avl_##name##_node_t* node) {                         \
+	return node ? node->height : 0;                                                         \
+}                                                                                           \
+                                                                                            \
+static inline void _avl_##name##_update(avl_##name##_node_t* node) {                        \
+	int left = _avl_##name##_height(node->left);                                            \
+	int right = _avl_##name##_height(node->right);                                          \
+	node->height = (left > right ? left : right) + 1;                                       \
+}                                                                                           \
+                                                                                            \
+static inline avl_##name##_node_t* _avl_##name##_rotate_left(avl_##name##_node_t* node) {   \
+	avl_##name##_node_t* y = node->right;                                                   \
+	node->right = y->left;                                                                  \
+	y->left = node;                                                                         \
+	_avl_##name##_update(node);                                                             \
+	_avl_##name##_update(y);                                                                \
+	return y;                                                                               \
+}                                                                                           \
+                                                                                            \
+static inline avl_##name##_node_t* _avl_##name##_rotate_right(avl_##name##_node_t* node) {  \
+	avl_##name##_node_t* x = node->left;                                                    \
+	node->left = x->right;                                                                  \
+	x->right = node;                                                                        \
+	_avl_##name##_update(node);                                                             \
+	_avl_##name##_update(x);                                                                \
+	return x;                                                                               \
+}                                                                                           \
+                                                                                            \
+static inline avl_##name##_node_t* _avl_##name##_balance(avl_##name##_node_t* node) {       \
+	_avl_##name##_update(node);                                                             \
+	int balance = _avl_##name##_height(node->left) - _avl_##name##_height(node->right);     \
+	if(balance > 1) {                                                                       \
+		if(_avl_##name##_height(node->left->left) < _avl_##name##_height(node->left->right)) \
+			node->left = _avl_##name##_rotate_left(node->left);                             \
+		return _avl_##name##_rotate_right(node);                                            \
+	}                                                                                       \
+	if(balance < -1) {                                                                      \
+		if(_avl_##name##_height(node->right->right) < _avl_##name##_height(node->right->left)) \
+			node->right = _avl_##name##_rotate_right(node->right);                          \
+		return _avl_##name##_rotate_left(node);                                             \
+	}                                                                                       \
+	return node;                                                                            \
+}                                                                                           \
+                                                                                            \
+/* rebalances the links from the changed subtree up, stops once a height holds */           \
+static inline void _avl_##name##_rebalance_path(avl_##name##_node_t** path[], int depth) {  \
+	while(depth-- > 0) {                                                                    \
+		avl_##name##_node_t** link = path[depth];                                           \
+		int height = (*link)->height;                                                       \
+		*link = _avl_##name##_balance(*link);                                               \
+		if((*link)->height == height)                                                       \
+			return;                                                                         \
+	}                                                                                       \
+}                                                                                           \
+                                                                                            \
+/* initialize an empty avl tree */                                                          \
+static inline avl_##name##_t* avl_##name##_init() {                                         \
+	avl_##name##_t* tree = calloc(1, sizeof(avl_##name##_t));                               \
+	return tree;                                                                            \
+}                                                                                           \
+                                                                                            \
+/* clears all elements from the tree */                                                     \
+static inline void avl_##name##_clear(avl_##name##_t* tree) {                               \
+	_avl_##name##_release(tree);                                                            \
+	tree->root = NULL;                                                                      \
+	tree->count = 0;                                                                        \
+}                                                                                           \
+                                                                                            \
+/* empty the memory of an avl tree */                                                       \
+static inline void avl_##name##_delete(avl_##name##_t* tree) {                              \
+	if(tree) {                                                                              \
+		_avl_##name##_release(tree);                                                        \
+		free(tree);                                                                         \
+	}                                                                                       \
+}                                                                                           \
+                                                                                            \
+/* insert an element in the avl tree, replacing the data of an equal key */                 \
+static inline clib_exit_code_t avl_##name##_insert(avl_##name##_t* tree, K key, V data) {   \
+	avl_##name##_node_t** path[TYPED_AVL_MAX_HEIGHT];                                       \
+	int depth = 0;                                                                          \
+	avl_##name##_node_t** link = &tree->root;                                               \
+	while(*link) {                                                                          \
+		int diff = cmp(key, (*link)->key);                                                  \
+		if(diff == 0) {                                                                     \
+			(*link)->data = data;                                                           \
+			return OK;                                                                      \
+		}                                                                                   \
+		path[depth++] = link;                                                               \
+		link = diff < 0 ? &(*link)->left : &(*link)->right;                                 \
+	}                                                                                       \
+	avl_##name##_node_t* node = _avl_##name##_alloc(tree);                                  \
+	if(node == NULL)                                                                        \
+		return OUT_OF_MEM;                                                                  \
+	node->left = node->right = NULL;                                                        \
+	node->height = 1;                                                                       \
+	node->key = key;                                                                        \
+	node->data = data;                                                                      \
+	*link = node;                                                                           \
+	tree->count++;                                                                          \
+	_avl_##name##_rebalance_path(path, depth);                                              \
+	return OK;                                                                              \
+}                                                                                           \
+                                                                                            \
+/* erase a specific key from the tree */                                                    \
+static inline void avl_##name##_erase(avl_##name##_t* tree, K key) {                        \
+	avl_##name##_node_t** path[TYPED_AVL_MAX_HEIGHT];                                       \
+	int depth = 0;                                                                          \
+	avl_##name##_node_t** link = &tree->root;                                               \
+	while(*link) {                                                                          \
+		int diff = cmp(key, (*link)->key);                                                  \
+		if(diff == 0)                                                                       \
+			break;                                                                          \
+		path[depth++] = link;                                                               \
+		link = diff < 0 ? &(*link)->left : &(*link)->right;                                 \
+	}                                                                                       \
+	avl_##name##_node_t* node = *link;                                                      \
+	if(node == NULL)                                                                        \
+		return;                                                                             \
+	if(node->left == NULL || node->right == NULL) {                                         \
+		*link = node->left ? node->left : node->right;                                      \
+	} else {                                                                                \
+		/* the successor is unlinked and takes the place of node */                         \
+		int node_depth = depth;                                                             \
+		path[depth++] = link;                                                               \
+		avl_##name##_node_t** next_link = &node->right;                                     \
+		while((*next_link)->left) {                                                         \
+			path[depth++] = next_link;                                                      \
+			next_link = &(*next_link)->left;                                                \
+		}                                                                                   \
+		avl_##name##_node_t* next = *next_link;                                             \
+		*next_link = next->right;                                                           \
+		next->left = node->left;                                                            \
+		next->right = node->right;                                                          \
+		next->height = node->height;                                                        \
+		*link = next;                                                                       \
+		if(depth > node_depth + 1)                                                          \
+			path[node_depth + 1] = &next->right;                                            \
+	}                                                                                       \
+	_avl_##name##_free(tree, node);                                                         \
+	tree->count--;                                                                          \
+	_avl_##name##_rebalance_path(path, depth);                                              \
+}                                                                                           \
+                                                                                            \
+/* search a specific key in the tree, NULL if missing */                                    \
+static inline V* avl_##name##_search(avl_##name##_t* tree, K key) {                         \
+	avl_##name##_node_t* node = tree->root;                                                 \
+	while(node) {                                                                           \
+		int diff = cmp(key, node->key);                                                     \
+		if(diff == 0)                                                                       \
+			return &node->data;                                                             \
+		node = diff < 0 ? node->left : node->right;                                         \
+	}                                                                                       \
+	return NULL;                                                                            \
+}                                                                                           \
+                                                                                            \
+/* return the first key bigger or equal to given key, NULL if none */                       \
+static inline const K* avl_##name##_lower_bound(avl_##name##_t* tree, K key) {              \
+	avl_##name##_node_t* node = tree->root;                                                 \
+	avl_##name##_node_t* result = NULL;                                                     \
+	while(node) {                                                                           \
+		int diff = cmp(key, node->key);                                                     \
+		if(diff == 0)                                                                       \
+			return &node->key;                                                              \
+		if(diff < 0) {                                                                      \
+			result = node;                                                                  \
+			node = node->left;                                                              \
+		} else                                                                              \
+			node = node->right;                                                             \
+	}                                                                                       \
+	return result ? &result->key : NULL;                                                    \
+}                                                                                           \
+                                                                                            \
+/* get the minimum key in the tree, NULL if empty */                                        \
+static inline const K* avl_##name##_min_key(avl_##name##_t* tree) {                         \
+	avl_##name##_node_t* node = tree->root;                                                 \
+	if(node == NULL)                                                                        \
+		return NULL;                                                                        \
+	while(node->left)                                                                       \
+		node = node->left;                                                                  \
+	return &node->key;                                                                      \
+}                                                                                           \
+                                                                                            \
+/* get the maximum key in the tree, NULL if empty */                                        \
+static inline const K* avl_##name##_max_key(avl_##name##_t* tree) {                         \
+	avl_##name##_node_t* node = tree->root;                                                 \
+	if(node == NULL)                                                                        \
+		return NULL;                                                                        \
+	while(node->right)                                                                      \
+		node = node->right;                                                                 \
+	return &node->key;                                                                      \
+}                                                                                           \
+                                                                                            \
+/* count the number of elements in the tree */                                              \
+static inline size_t avl_##name##_count(const avl_##name##_t* tree) {                       \
+	return tree->count;                                                                     \
+}
+
+#endif
@@ -0,0 +1,140 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+Type specialized binary heap generator in C
+*/
+
+#ifndef CTYPED_BHEAP_H
+#define CTYPED_BHEAP_H
+
+#include <stdlib.h>
+
+#include "utils.h"
+
+// BHEAP_DEFINE(name, T, less) emits bheap_name_t, a binary heap of T whose top
+// is the smallest element according to less(a, b), and its static inline
+// operations bheap_name_*. less may be a function or a macro; it is called
+// directly so the compiler can inline it instead of going through a pointer.
+//
+//     #define I64_LESS(a, b) ((a) < (b))
+//     BHEAP_DEFINE(i64, int64_t, I64_LESS)
+
+#define BHEAP_DEFINE(name, T, less)                                                         \
+                                                                                            \
+typedef struct bheap_##name##_s {                                                           \
+	size_t capacity;                                                                        \
+	size_t count;                                                                           \
+	T* data;                                                                                \
+} bheap_##name##_t;                                                                         \
+                                                                                            \
+/* moves data[it] down into its place among the first count elements */                     \
+static inline void _bheap_##name##_sift_down(T* data, size_t count, size_t it) {            \
+	T value = data[it];                                                                     \
+	size_t child;                                                                           \
+	while((child = 2 * it + 1) < count) {                                                   \
+		if(child + 1 < count && less(data[child + 1], data[child]))                         \
+			child++;                                                                        \
+		if(!less(data[child], value))                                                       \
+			break;                                                                          \
+		data[it] = data[child];                                                             \
+		it = child;                                                                         \
+	}                                                                                       \
+	data[it] = value;                                                                       \
+}                                                                                           \
+                                                                                            \
+/* same as sift_down with the largest element on top, used by sort */                       \
+static inline void _bheap_##name##_sift_down_max(T* data, size_t count, size_t it) {        \
+	T value = data[it];                                                                     \
+	size_t child;                                                                           \
+	while((child = 2 * it + 1) < count) {                                                   \
+		if(child + 1 < count && less(data[child], data[child + 1]))                         \
+			child++;                                                                        \
+		if(!less(value, data[child]))                                                       \
+			break;                                                                          \
+		data[it] = data[child];                                                             \
+		it = child;                                                                         \
+	}                                                                                       \
+	data[it] = value;                                                                       \
+}                                                                                           \
+                                                                                            \
+/* creates a binary heap ready to use */                                                    \
+static inline bheap_##name##_t* bheap_##name##_init(size_t capacity) {                      \
+	bheap_##name##_t* heap = malloc(sizeof(bheap_##name##_t));                              \
+	if(heap == NULL)                                                                        \
+		return NULL;                                                                        \
+	heap->capacity = capacity ? capacity : 1;                                               \
+	heap->count = 0;                                                                        \
+	heap->data = malloc(heap->capacity * sizeof(T));                                        \
+	if(heap->data == NULL) {                                                                \
+		free(heap);                                                                         \
+		return NULL;                                                                        \
+	}                                                                                       \
+	return heap;                                                                            \
+}                                                                                           \
+                                                                                            \
+/* deletes a binary heap from memory */                                                     \
+static inline clib_exit_code_t bheap_##name##_delete(bheap_##name##_t* heap) {              \
+	if(heap == NULL)                                                                        \
+		return NULL_REF;                                                                    \
+	free(heap->data);                                                                       \
+	free(heap);                                                                             \
+	return OK;                                                                              \
+}                                                                                           \
+                                                                                            \
+/* inserts an element in the heap */                                                        \
+static inline clib_exit_code_t bheap_##name##_insert(bheap_##name##_t* heap, T value) {     \
+	if(heap->count == heap->capacity) {                                                     \
+		T* tmp = realloc(heap->data, 2 * heap->capacity * sizeof(T));                       \
+		if(tmp == NULL)                                                                     \
+			return OUT_OF_MEM;                                                              \
+		heap->data = tmp;                                                                   \
+		heap->capacity *= 2;                                                                \
+	}                                                                                       \
+	size_t it = heap->count++;                                                              \
+	while(it != 0 && less(value, heap->data[(it - 1) / 2])) {                               \
+		heap->data[it] = heap->data[(it - 1) / 2];                                          \
+		it = (it - 1) / 2;                                                                  \
+	}                                                                                       \
+	heap->data[it] = value;                                                                 \
+	return OK;                                                                              \
+}                                                                                           \
+                                                                                            \
+/* remove the top of the heap */                                                            \
+static inline void bheap_##name##_pop(bheap_##name##_t* heap) {                             \
+	if(heap->count <= 1) {                                                                  \
+		heap->count = 0;                                                                    \
+		return;                                                                             \
+	}                                                                                       \
+	heap->data[0] = heap->data[--heap->count];                                              \
+	_bheap_##name##_sift_down(heap->data, heap->count, 0);                                  \
+}                                                                                           \
+                                                                                            \
+/* get the element at the top of the heap, the heap must not be empty */                    \
+static inline T bheap_##name##_get_top(const bheap_##name##_t* heap) {                      \
+	return heap->data[0];                                                                   \
+}                                                                                           \
+                                                                                            \
+/* clears all the data from a heap */                                                       \
+static inline void bheap_##name##_clear(bheap_##name##_t* heap) {                           \
+	heap->count = 0;                                                                        \
+}                                                                                           \
+                                                                                            \
+/* get the number of elements in the heap */                                                \
+static inline size_t bheap_##name##_count(const bheap_##name##_t* heap) {                   \
+	return heap->count;                                                                     \
+}                                                                                           \
+                                                                                            \
+/* sorts an array in place using heap sort, ascending by less */                            \
+static inline void bheap_##name##_sort(T* array, size_t count) {                            \
+	if(count < 2)                                                                           \
+		return;                                                                             \
+	for(size_t i = count / 2; i-- > 0;)                                                     \
+		_bheap_##name##_sift_down_max(array, count, i);                                     \
+	for(size_t end = count - 1; end > 0; end--) {                                           \
+		T tmp = array[0];                                                                   \
+		array[0] = array[end];                                                              \
+		array[end] = tmp;                                                                   \
+		_bheap_##name##_sift_down_max(array, end, 0);                                       \
+	}                                                                                       \
+}
+
+#endif
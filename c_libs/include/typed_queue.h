@@ -0,0 +1,96 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+Type specialized queue generator in C
+*/
+
+#ifndef CTYPED_QUEUE_H
+#define CTYPED_QUEUE_H
+
+#include <stdlib.h>
+
+#include "utils.h"
+
+// QUEUE_DEFINE(name, T) emits queue_name_t, a ring buffer of T with a power
+// of two capacity, and its static inline operations queue_name_*.
+//
+//     QUEUE_DEFINE(u32, uint32_t)
+//     queue_u32_t* queue = queue_u32_init();
+//     queue_u32_push(queue, 7);
+
+#define QUEUE_DEFINE(name, T)                                                               \
+                                                                                            \
+typedef struct queue_##name##_s {                                                           \
+	size_t head;                                                                            \
+	size_t count;                                                                           \
+	size_t mask;                                                                            \
+	T* data;                                                                                \
+} queue_##name##_t;                                                                         \
+                                                                                            \
+/* initialize a queue */                                                                    \
+static inline queue_##name##_t* queue_##name##_init() {                                     \
+	queue_##name##_t* queue = malloc(sizeof(queue_##name##_t));                             \
+	if(queue == NULL)                                                                       \
+		return NULL;                                                                        \
+	queue->data = malloc(16 * sizeof(T));                                                   \
+	if(queue->data == NULL) {                                                               \
+		free(queue);                                                                        \
+		return NULL;                                                                        \
+	}                                                                                       \
+	queue->head = 0;                                                                        \
+	queue->count = 0;                                                                       \
+	queue->mask = 15;                                                                       \
+	return queue;                                                                           \
+}                                                                                           \
+                                                                                            \
+/* delete a queue */                                                                        \
+static inline clib_exit_code_t queue_##name##_delete(queue_##name##_t* queue) {             \
+	if(queue == NULL)                                                                       \
+		return NULL_REF;                                                                    \
+	free(queue->data);                                                                      \
+	free(queue);                                                                            \
+	return OK;                                                                              \
+}                                                                                           \
+                                                                                            \
+/* push an element on the queue tail */                                                     \
+static inline clib_exit_code_t queue_##name##_push(queue_##name##_t* queue, T value) {      \
+	if(queue->count > queue->mask) {                                                        \
+		size_t capacity = queue->mask + 1;                                                  \
+		T* tmp = malloc(2 * capacity * sizeof(T));                                          \
+		if(tmp == NULL)                                                                     \
+			return OUT_OF_MEM;                                                              \
+		for(size_t i = 0; i < capacity; i++)                                                \
+			tmp[i] = queue->data[(queue->head + i) & queue->mask];                          \
+		free(queue->data);                                                                  \
+		queue->data = tmp;                                                                  \
+		queue->head = 0;                                                                    \
+		queue->mask = 2 * capacity - 1;                                                     \
+	}                                                                                       \
+	queue->data[(queue->head + queue->count++) & queue->mask] = value;                      \
+	return OK;                                                                              \
+}                                                                                           \
+                                                                                            \
+/* erase the element at the head of the queue */                                            \
+static inline void queue_##name##_pop(queue_##name##_t* queue) {                            \
+	if(queue->count) {                                                                      \
+		queue->head = (queue->head + 1) & queue->mask;                                      \
+		queue->count--;                                                                     \
+	}                                                                                       \
+}                                                                                           \
+                                                                                            \
+/* get the head of the queue, the queue must not be empty */                                \
+static inline T queue_##name##_head(const queue_##name##_t* queue) {                        \
+	return queue->data[queue->head];                                                        \
+}                                                                                           \
+                                                                                            \
+/* delete all elements from the queue */                                                    \
+static inline void queue_##name##_clear(queue_##name##_t* queue) {                          \
+	queue->head = 0;                                                                        \
+	queue->count = 0;                                                                       \
+}                                                                                           \
+                                                                                            \
+/* get the number of elements in the queue */                                              \
+static inline size_t queue_##name##_count(const queue_##name##_t* queue) {                  \
+	return queue->count;                                                                    \
+}
+
+#endif
@@ -0,0 +1,83 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+Type specialized stack generator in C
+*/
+
+#ifndef CTYPED_STACK_H
+#define CTYPED_STACK_H
+
+#include <stdlib.h>
+
+#include "utils.h"
+
+// STACK_DEFINE(name, T) emits stack_name_t, an array backed stack of T,
+// and its static inline operations stack_name_*.
+//
+//     STACK_DEFINE(ptr, void*)
+//     stack_ptr_t* stack = stack_ptr_init();
+//     stack_ptr_push(stack, node);
+
+#define STACK_DEFINE(name, T)                                                               \
+                                                                                            \
+typedef struct stack_##name##_s {                                                           \
+	size_t count;                                                                           \
+	size_t capacity;                                                                        \
+	T* data;                                                                                \
+} stack_##name##_t;                                                                         \
+                                                                                            \
+/* initialize an empty stack */                                                             \
+static inline stack_##name##_t* stack_##name##_init() {                                     \
+	stack_##name##_t* stack = malloc(sizeof(stack_##name##_t));                             \
+	if (!stack)                                                                             \
+		return NULL;                                                                        \
+	stack->count = 0;                                                                       \
+	stack->capacity = 0;                                                                    \
+	stack->data = NULL;                                                                     \
+	return stack;                                                                           \
+}                                                                                           \
+                                                                                            \
+/* delete a stack */                                                                        \
+static inline clib_exit_code_t stack_##name##_delete(stack_##name##_t* stack) {             \
+	if (!stack)                                                                             \
+		return NULL_REF;                                                                    \
+	free(stack->data);                                                                      \
+	free(stack);                                                                            \
+	return OK;                                                                              \
+}                                                                                           \
+                                                                                            \
+/* push an element at the top of the stack */                                               \
+static inline clib_exit_code_t stack_##name##_push(stack_##name##_t* stack, T value) {      \
+	if (stack->count == stack->capacity) {                                                  \
+		size_t capacity = stack->capacity ? 2 * stack->capacity : 16;                       \
+		T* tmp = realloc(stack->data, capacity * sizeof(T));                                \
+		if (!tmp)                                                                           \
+			return OUT_OF_MEM;                                                              \
+		stack->data = tmp;                                                                  \
+		stack->capacity = capacity;                                                         \
+	}                                                                                       \
+	stack->data[stack->count++] = value;                                                    \
+	return OK;                                                                              \
+}                                                                                           \
+                                                                                            \
+/* remove the top of the stack */                                                           \
+static inline void stack_##name##_pop(stack_##name##_t* stack) {                            \
+	if (stack->count)                                                                       \
+		stack->count--;                                                                     \
+}                                                                                           \
+                                                                                            \
+/* get the top of the stack, the stack must not be empty */                                 \
+static inline T stack_##name##_top(const stack_##name##_t* stack) {                         \
+	return stack->data[stack->count - 1];                                                   \
+}                                                                                           \
+                                                                                            \
+/* clear all elements in stack */                                                           \
+static inline void stack_##name##_clear(stack_##name##_t* stack) {                          \
+	stack->count = 0;                                                                       \
+}                                                                                           \
+                                                                                            \
+/* count the number of elements in stack */                                                 \
+static inline size_t stack_##name##_count(const stack_##name##_t* stack) {                  \
+	return stack->count;                                                                    \
+}
+
+#endif
@@ -0,0 +1,120 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+Type specialized vector generator in C
+*/
+
+#ifndef CTYPED_VECTOR_H
+#define CTYPED_VECTOR_H
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "utils.h"
+
+// VECTOR_DEFINE(name, T) emits vector_name_t storing T elements and its
+// static inline operations vec_name_*. Elements are moved by assignment
+// instead of a runtime data_size memcpy, so loops over them can be inlined
+// and vectorized by the compiler.
+//
+//     VECTOR_DEFINE(i64, int64_t)
+//     vector_i64_t* vec = vec_i64_init(16);
+//     vec_i64_push_back(vec, 42);
+
+#define VECTOR_DEFINE(name, T)                                                              \
+                                                                                            \
+typedef struct vector_##name##_s {                                                          \
+	size_t count;                                                                           \
+	size_t capacity;                                                                        \
+	T* data;                                                                                \
+} vector_##name##_t;                                                                        \
+                                                                                            \
+/* initialize an empty vector */                                                            \
+static inline vector_##name##_t* vec_##name##_init(size_t capacity) {                       \
+	vector_##name##_t* vec = malloc(sizeof(vector_##name##_t));                             \
+	if(vec == NULL)                                                                         \
+		return NULL;                                                                        \
+	vec->capacity = capacity ? capacity : 1;                                                \
+	vec->count = 0;                                                                         \
+	vec->data = malloc(vec->capacity * sizeof(T));                                          \
+	if(vec->data == NULL) {                                                                 \
+		free(vec);                                                                          \
+		return NULL;                                                                        \
+	}                                                                                       \
+	return vec;                                                                             \
+}                                                                                           \
+                                                                                            \
+/* delete a vector */                                                                       \
+static inline clib_exit_code_t vec_##name##_delete(vector_##name##_t* vec) {                \
+	if(vec == NULL)                                                                         \
+		return NULL_REF;                                                                    \
+	free(vec->data);                                                                        \
+	free(vec);                                                                              \
+	return OK;                                                                              \
+}                                                                                           \
+                                                                                            \
+/* make sure the vector can hold capacity elements */                                       \
+static inline clib_exit_code_t vec_##name##_reserve(vector_##name##_t* vec, size_t capacity) { \
+	if(capacity <= vec->capacity)                                                           \
+		return OK;                                                                          \
+	T* tmp = realloc(vec->data, capacity * sizeof(T));                                      \
+	if(tmp == NULL)                                                                         \
+		return OUT_OF_MEM;                                                                  \
+	vec->data = tmp;                                                                        \
+	vec->capacity = capacity;                                                               \
+	return OK;                                                                              \
+}                                                                                           \
+                                                                                            \
+/* resize the vector to given count, new elements are zeroed */                             \
+static inline clib_exit_code_t vec_##name##_resize(vector_##name##_t* vec, size_t count) {  \
+	clib_exit_code_t err = vec_##name##_reserve(vec, count);                                \
+	if(err != OK)                                                                           \
+		return err;                                                                         \
+	if(count > vec->count)                                                                  \
+		memset(vec->data + vec->count, 0, (count - vec->count) * sizeof(T));                \
+	vec->count = count;                                                                     \
+	return OK;                                                                              \
+}                                                                                           \
+                                                                                            \
+/* insert a new element at the end of the vector */                                         \
+static inline clib_exit_code_t vec_##name##_push_back(vector_##name##_t* vec, T value) {    \
+	if(vec->count == vec->capacity) {                                                       \
+		clib_exit_code_t err = vec_##name##_reserve(vec, 2 * vec->capacity);                \
+		if(err != OK)                                                                       \
+			return err;                                                                     \
+	}                                                                                       \
+	vec->data[vec->count++] = value;                                                        \
+	return OK;                                                                              \
+}                                                                                           \
+                                                                                            \
+/* remove the last element in the vector */                                                 \
+static inline void vec_##name##_remove_back(vector_##name##_t* vec) {                       \
+	if(vec->count)                                                                          \
+		vec->count--;                                                                       \
+}                                                                                           \
+                                                                                            \
+/* get the element at given index, index must be in bounds */                               \
+static inline T vec_##name##_get(const vector_##name##_t* vec, size_t index) {              \
+	return vec->data[index];                                                                \
+}                                                                                           \
+                                                                                            \
+/* pointer to the element at given index, index must be in bounds */                        \
+static inline T* vec_##name##_at(vector_##name##_t* vec, size_t index) {                    \
+	return vec->data + index;                                                               \
+}                                                                                           \
+                                                                                            \
+/* set the element at given index, index must be in bounds */                               \
+static inline void vec_##name##_set(vector_##name##_t* vec, size_t index, T value) {        \
+	vec->data[index] = value;                                                               \
+}                                                                                           \
+                                                                                            \
+/* clear all elements, keeps the capacity */                                                \
+static inline void vec_##name##_clear(vector_##name##_t* vec) {                             \
+	vec->count = 0;                                                                         \
+}                                                                                           \
+                                                                                            \
+/* get the count of a vector */                                                             \
+static inline size_t vec_##name##_count(const vector_##name##_t* vec) {                     \
+	return vec->count;                                                                      \
+}
+
+#endif
@@ -12,6 +12,15 @@ A vector implementation in C
 
 #include "utils.h"
 
+typedef enum vec_key_e {
+	VEC_KEY_INT32,
+	VEC_KEY_UINT32,
+	VEC_KEY_INT64,
+	VEC_KEY_UINT64,
+	VEC_KEY_FLOAT,
+	VEC_KEY_DOUBLE
+} vec_key_t;
+
 typedef struct vector_s {
 	size_t count;
 	size_t capacity;
@@ -89,4 +98,64 @@ size_t vec_capacity(vector_t* vec);
 // prints an integer vector
 void vec_int_print(vector_t* vec);
 
+
+// sorts the vector with a stable merge sort split across threads
+// compare(a, b) is true when a must come after b, like for bheap_sort
+// threads = 0 uses one thread per online core, small vectors use fewer
+clib_exit_code_t vec_sort_parallel(vector_t* vec, uint8_t (*compare)(const void*, const void*), size_t threads);
+
+
+// sorts a vector of numbers ascending with a parallel LSD radix sort
+// the data size of the vector must be the size of the key type
+clib_exit_code_t vec_radix_sort_parallel(vector_t* vec, vec_key_t key, size_t threads);
+
+
+// Unchecked fast path =============================================================================
+// No NULL or bounds checks and no messages, for hot loops over valid vectors.
+
+
+// grow the capacity to at least min_capacity, doubling it at least
+clib_exit_code_t _vec_grow(vector_t* vec, size_t min_capacity);
+
+
+// pointer to the contiguous elements of the vector
+static inline void* vec_data(vector_t* vec) {
+	return vec->data;
+}
+
+
+// pointer to the element at given index, index must be smaller than the count
+static inline void* vec_at_unchecked(vector_t* vec, size_t index) {
+	return (char*)(vec->data) + index * vec->data_size;
+}
+
+
+// make sure the vector can hold capacity elements without reallocating
+static inline clib_exit_code_t vec_reserve(vector_t* vec, size_t capacity) {
+	if(capacity <= vec->capacity)
+		return OK;
+	return _vec_grow(vec, capacity);
+}
+
+
+// append an uninitialized element and return a pointer to it, NULL if out of memory
+static inline void* vec_emplace_back(vector_t* vec) {
+	if(vec->count == vec->capacity && _vec_grow(vec, vec->count + 1) != OK)
+		return NULL;
+	return (char*)(vec->data) + (vec->count++) * vec->data_size;
+}
+
+
+// append count contiguous elements with a single copy
+static inline clib_exit_code_t vec_append_n(vector_t* vec, const void* data, size_t count) {
+	clib_exit_code_t err = vec_reserve(vec, vec->count + count);
+	if(err != OK)
+		return err;
+
+	memcpy((char*)(vec->data) + vec->count * vec->data_size, data, count * vec->data_size);
+	vec->count += count;
+
+	return OK;
+}
+
 #endif
@@ -1,5 +1,30 @@
 #include "./../include/avl.h"
 
+#include <stddef.h>
+#include <stdio.h>
+
+#include "./../include/utils.h"
+
+#define AVL_MAX_ALIGN 16
+#define AVL_SLAB_MIN 64
+#define AVL_SLAB_MAX 4096
+
+#define NODE_KEY(tree, node) ((void*)((char*)(node) + (tree)->key_offset))
+#define NODE_DATA(tree, node) ((void*)((char*)(node) + (tree)->data_offset))
+
+
+// alignment a field of this size needs, the largest power of two dividing it
+static size_t _avl_align_of(size_t size) {
+	size_t align = 1;
+	while(align < AVL_MAX_ALIGN && size % (2 * align) == 0)
+		align *= 2;
+	return align;
+}
+
+static size_t _avl_align_up(size_t offset, size_t align) {
+	return (offset + align - 1) / align * align;
+}
+
 avl_tree_t* avl_tree_init(unsigned int data_size, unsigned int key_size, int (*comparation)(const void*, const void*)) {
 	avl_tree_t* tree = (avl_tree_t*)malloc(sizeof(avl_tree_t));
 	if(tree == NULL)
@@ -11,37 +36,102 @@ avl_tree_t* avl_tree_init(unsigned int data_size, unsigned int key_size, int (*c
 	tree->key_size = key_size;
 	tree->comparation = comparation;
 
+	// header, key, data, each aligned, padded so consecutive nodes stay aligned
+	size_t key_align = _avl_align_of(key_size);
+	size_t data_align = _avl_align_of(data_size);
+	size_t node_align = _max(_Alignof(avl_node_t), _max(key_align, data_align));
+
+	tree->key_offset = _avl_align_up(offsetof(avl_node_t, payload), key_align);
+	tree->data_offset = _avl_align_up(tree->key_offset + key_size, data_align);
+	tree->node_size = _avl_align_up(tree->data_offset + data_size, node_align);
+
+	memset(&tree->pool, 0, sizeof(avl_pool_t));
+
 	return tree;
 }
 
+// NODE POOL
+
+// slabs start with the link to the previous one, nodes follow aligned
+static avl_node_t* _avl_pool_alloc(avl_tree_t* tree) {
+	avl_pool_t* pool = &tree->pool;
+
+	if(pool->free_nodes) {
+		avl_node_t* node = pool->free_nodes;
+		pool->free_nodes = node->left;
+		return node;
+	}
+
+	if(pool->remaining == 0) {
+		size_t nodes = pool->slab_nodes ? _min(2 * pool->slab_nodes, AVL_SLAB_MAX) : AVL_SLAB_MIN;
+		void** slab = malloc(AVL_MAX_ALIGN + nodes * tree->node_size);
+		if(slab == NULL)
+			return NULL;
+
+		*slab = pool->slabs;
+		pool->slabs = slab;
+		pool->next = (char*)slab + AVL_MAX_ALIGN;
+		pool->remaining = nodes;
+		pool->slab_nodes = nodes;
+	}
+
+	avl_node_t* node = (avl_node_t*)pool->next;
+	pool->next += tree->node_size;
+	pool->remaining--;
+
+	return node;
+}
+
+// makes the next nodes come from one slab big enough for all of them,
+// meant for empty trees, what is left of the current slab is not reused
+static clib_exit_code_t _avl_pool_reserve(avl_tree_t* tree, size_t nodes) {
+	avl_pool_t* pool = &tree->pool;
+
+	if(nodes <= pool->remaining)
+		return OK;
+
+	void** slab = malloc(AVL_MAX_ALIGN + nodes * tree->node_size);
+	if(slab == NULL)
+		return OUT_OF_MEM;
+
+	*slab = pool->slabs;
+	pool->slabs = slab;
+	pool->next = (char*)slab + AVL_MAX_ALIGN;
+	pool->remaining = nodes;
+	pool->slab_nodes = _min(nodes, AVL_SLAB_MAX);
+
+	return OK;
+}
+
+// frees every node at once
+static void _avl_pool_release(avl_pool_t* pool) {
+	void* slab = pool->slabs;
+
+	while(slab) {
+		void* prev = *(void**)slab;
+		free(slab);
+		slab = prev;
+	}
+
+	memset(pool, 0, sizeof(avl_pool_t));
+}
+
 int avl_tree_count(avl_tree_t* tree) {
 	if(tree)
 		return tree->count;
 	return 0;
 }
 
-void _avl_free_node(avl_node_t* node) {
+void _avl_free_node(avl_tree_t* tree, avl_node_t* node) {
 	if(node) {
-		free(node->data);
-		free(node->key);
-		free(node);
-	}
-}
-
-void _avl_node_delete(avl_node_t* node) {
-	if(node) {
-		_avl_node_delete(node->left);
-		_avl_node_delete(node->right);
-
-		free(node->data);
-		free(node->key);
-		free(node);
+		node->left = tree->pool.free_nodes;
+		tree->pool.free_nodes = node;
 	}
 }
 
 void avl_tree_delete(avl_tree_t* tree) {
 	if(tree) {
-		_avl_node_delete(tree->root);
+		_avl_pool_release(&tree->pool);
 		free(tree);
 	}
 }
@@ -53,13 +143,22 @@ int _avl_node_height(avl_node_t *node) {
 	return node->height;
 }
 
-void _avl_node_update_height(avl_node_t *node) {
+unsigned int _avl_node_size(avl_node_t *node) {
+	if(node == NULL)
+		return 0;
+
+	return node->size;
+}
+
+// recomputes the height and the subtree size from the children
+void _avl_node_update(avl_node_t *node) {
 	if(node == NULL)
 		return;
 	int left = _avl_node_height(node->left);
 	int right = _avl_node_height(node->right);
 
 	node->height = (left > right ? left : right) + 1;
+	node->size = _avl_node_size(node->left) + _avl_node_size(node->right) + 1;
 }
 
 int _avl_node_balance_factor(avl_node_t* node) {
@@ -76,8 +175,8 @@ avl_node_t* _avl_node_rotate_left(avl_node_t* node) {
     y->left = node;
     node->right = tmp;
 
-    _avl_node_update_height(node);
-	_avl_node_update_height(y);
+    _avl_node_update(node);
+	_avl_node_update(y);
  
     return y;
 }
@@ -89,105 +188,107 @@ avl_node_t* _avl_node_rotate_right(avl_node_t* node) {
     x->right = node;
     node->left = tmp;
  
-    _avl_node_update_height(node);
-	_avl_node_update_height(x);
+    _avl_node_update(node);
+	_avl_node_update(x);
  
     return x;
 }
 
-avl_node_t* _avl_node_new(avl_tree_t* tree, void* key, void* data) {
-	avl_node_t* new_node = (avl_node_t*)malloc(sizeof(avl_node_t));
+avl_node_t* _avl_node_new(avl_tree_t* tree, const void* key, const void* data) {
+	avl_node_t* new_node = _avl_pool_alloc(tree);
 	if(new_node == NULL)
 		return NULL;
 
-	new_node->key = malloc(tree->key_size);
-	if(new_node->key == NULL) {
-		free(new_node);
-		return NULL;
-	}
-
-	new_node->data = malloc(tree->data_size);
-	if(new_node->data == NULL) {
-		free(new_node->key);
-		free(new_node);
-		return NULL;
-	}
-
-	memcpy(new_node->data, data, tree->data_size);
-	memcpy(new_node->key, key, tree->key_size);
+	memcpy(NODE_DATA(tree, new_node), data, tree->data_size);
+	memcpy(NODE_KEY(tree, new_node), key, tree->key_size);
 	new_node->left = NULL;
 	new_node->right = NULL;
 	new_node->height = 1;
+	new_node->size = 1;
 
 	return new_node;
 }
 
-avl_node_t* _avl_node_insert(avl_tree_t* tree, avl_node_t* node, void* key, void* data) {
-	if(node == NULL) {
-		tree->count++;
-		return _avl_node_new(tree, key, data);
-	}
+// restores balance at node after one of its subtrees changed height by one
+avl_node_t* _avl_node_rebalance(avl_node_t* node) {
+	_avl_node_update(node);
 
-	int diff = tree->comparation(key, node->key);
+	int balance_factor = _avl_node_balance_factor(node);
 
-	if (diff < 0)
-		node->left = _avl_node_insert(tree, node->left, key, data);
-	else if (diff > 0)
-		node->right = _avl_node_insert(tree, node->right, key, data);
-	else {
-		memcpy(node->data, data, tree->data_size);
-		return node;
+	if(balance_factor > 1) {
+		if(_avl_node_balance_factor(node->left) < 0)
+			node->left = _avl_node_rotate_left(node->left);
+		return _avl_node_rotate_right(node);
 	}
 
-	_avl_node_update_height(node);
-
-	int balance_factor = _avl_node_balance_factor(node);
+	if(balance_factor < -1) {
+		if(_avl_node_balance_factor(node->right) > 0)
+			node->right = _avl_node_rotate_right(node->right);
+		return _avl_node_rotate_left(node);
+	}
 
-	int diff_1 = 0;
-	if(balance_factor > 1)
-		diff_1 = tree->comparation(key, node->left->key);
-	int diff_2 = 0;
-	if(balance_factor < -1)
-		diff_2 = tree->comparation(key, node->right->key);
+	return node;
+}
 
-	if(balance_factor > 1 && diff_1 < 0)
-		return _avl_node_rotate_right(node);
+// path holds the links from the root down to the changed subtree,
+// rotations stop as soon as a subtree keeps its height, only the sizes change above it
+void _avl_rebalance_path(avl_node_t** path[], int depth) {
+	while(depth-- > 0) {
+		avl_node_t** link = path[depth];
+		int height = (*link)->height;
 
-	if(balance_factor < -1 && diff_2 > 0)
-		return _avl_node_rotate_left(node);
+		*link = _avl_node_rebalance(*link);
 
-	if(balance_factor > 1 &&  diff_1 > 0) {
-		node->left = _avl_node_rotate_left(node->left);
-		return _avl_node_rotate_right(node);
+		if((*link)->height == height)
+			break;
 	}
 
-	if(balance_factor < -1 && diff_2 < 0) {
-		node->right = _avl_node_rotate_right(node->right);
-		return _avl_node_rotate_left(node);
+	while(depth-- > 0) {
+		avl_node_t* node = *path[depth];
+		node->size = _avl_node_size(node->left) + _avl_node_size(node->right) + 1;
 	}
-
-	return node;
 }
 
 void avl_tree_insert(avl_tree_t* tree, void* key, void* data) {
 	if(tree == NULL)
 		return;
-	tree->root = _avl_node_insert(tree, tree->root, key, data);
+
+	avl_node_t** path[AVL_MAX_HEIGHT];
+	int depth = 0;
+	avl_node_t** link = &tree->root;
+
+	while(*link) {
+		int diff = tree->comparation(key, NODE_KEY(tree, *link));
+		if(diff == 0) {
+			memcpy(NODE_DATA(tree, *link), data, tree->data_size);
+			return;
+		}
+
+		path[depth++] = link;
+		link = diff < 0 ? &(*link)->left : &(*link)->right;
+	}
+
+	*link = _avl_node_new(tree, key, data);
+	if(*link == NULL)
+		return;
+
+	tree->count++;
+	_avl_rebalance_path(path, depth);
 }
 
 avl_node_t* _avl_node_min(avl_node_t* node) {
 	if(node == NULL)
-		return 0;
-	if(node->left)
-		return _avl_node_min(node->left);
+		return NULL;
+	while(node->left)
+		node = node->left;
 	return node;
 }
 
 avl_node_t* _avl_node_max(avl_node_t* node) {
 	if(node == NULL)
-		return 0;
-	if(node->right)
-		return _avl_node_max(node->right);
+		return NULL;
+	while(node->right)
+		node = node->right;
 	return node;
 }
 
@@ -196,7 +297,7 @@ const void* avl_min_key(avl_tree_t* tree) {
 		return 0;
 	avl_node_t* node = _avl_node_min(tree->root);
 	if(node)
-		return node->key;
+		return NODE_KEY(tree, node);
 	else 
 		return 0;
 }
@@ -206,80 +307,122 @@ const void* avl_max_key(avl_tree_t* tree) {
 		return 0;
 	avl_node_t* node = _avl_node_max(tree->root);
 	if(node)
-		return node->key;
+		return NODE_KEY(tree, node);
 	else
 		return 0;
 }
 
-avl_node_t* _avl_node_erase(avl_tree_t* tree, avl_node_t* node, void* key) {
+void avl_tree_erase(avl_tree_t* tree, void* key) {
+	if(tree == NULL)
+		return;
+
+	avl_node_t** path[AVL_MAX_HEIGHT];
+	int depth = 0;
+	avl_node_t** link = &tree->root;
+
+	while(*link) {
+		int diff = tree->comparation(key, NODE_KEY(tree, *link));
+		if(diff == 0)
+			break;
+
+		path[depth++] = link;
+		link = diff < 0 ? &(*link)->left : &(*link)->right;
+	}
+
+	avl_node_t* node = *link;
 	if(node == NULL)
-		return NULL;
+		return;
 
-	int diff = tree->comparation(key, node->key);
-
-	if(diff < 0)
-		node->left = _avl_node_erase(tree, node->left, key);
-	else if(diff > 0)
-		node->right = _avl_node_erase(tree, node->right, key);
-	else {
-		if((node->left == NULL) || (node->right == NULL)) {
-			avl_node_t* next = node->left;
-			if(next == NULL)
-				next = node->right;
-
-			if(next == NULL) {
-				next = node;
-				node = NULL;
-			} else {
-				node->left = next->left;
-				node->right = next->right;
-				node->height = next->height;
-				memcpy(node->key, next->key, tree->key_size);
-				memcpy(node->data, next->data, tree->data_size);
-			}
-
-			_avl_free_node(next);
-			tree->count--;
-		} else {
-			avl_node_t* right_min_key = _avl_node_min(node->right);
+	if(node->left == NULL || node->right == NULL) {
+		*link = node->left ? node->left : node->right;
+	} else {
+		// the successor is unlinked and takes the place of node
+		int node_depth = depth;
+		path[depth++] = link;
+
+		avl_node_t** next_link = &node->right;
+		while((*next_link)->left) {
+			path[depth++] = next_link;
+			next_link = &(*next_link)->left;
+		}
+
+		avl_node_t* next = *next_link;
+		*next_link = next->right;
 
-			memcpy(node->key, right_min_key->key, tree->key_size);
-			memcpy(node->data, right_min_key->data, tree->data_size);
+		next->left = node->left;
+		next->right = node->right;
+		next->height = node->height;
+		next->size = node->size;
+		*link = next;
+
+		// the link below the moved node now lives in the successor
+		if(depth > node_depth + 1)
+			path[node_depth + 1] = &next->right;
+	}
+
+	_avl_free_node(tree, node);
+	tree->count--;
+	_avl_rebalance_path(path, depth);
+}
 
-			node->right = _avl_node_erase(tree, node->right, right_min_key->key);
+size_t avl_rank(avl_tree_t* tree, const void* key) {
+	if(tree == NULL || key == NULL)
+		return 0;
+
+	size_t rank = 0;
+	avl_node_t* node = tree->root;
+
+	while(node) {
+		int diff = tree->comparation(key, NODE_KEY(tree, node));
+		if(diff == 0)
+			return rank + _avl_node_size(node->left);
+
+		if(diff < 0) {
+			node = node->left;
+		} else {
+			rank += _avl_node_size(node->left) + 1;
+			node = node->right;
 		}
 	}
 
-	if(node == NULL)
+	return rank;
+}
+
+// the node holding the index-th smallest key, the path to it goes in cursor when one is given
+avl_node_t* _avl_select(avl_tree_t* tree, size_t index, avl_cursor_t* cursor) {
+	if(index >= tree->count)
 		return NULL;
 
-	_avl_node_update_height(node);
+	avl_node_t* node = tree->root;
 
-	int balance_factor = _avl_node_balance_factor(node);
+	while(node) {
+		if(cursor)
+			cursor->path[cursor->depth++] = node;
 
-	if (balance_factor > 1 && _avl_node_balance_factor(node->left) >= 0)
-        return _avl_node_rotate_right(node);
+		size_t left = _avl_node_size(node->left);
+		if(index == left)
+			return node;
 
-    if (balance_factor < -1 && _avl_node_balance_factor(node->right) <= 0)
-        return _avl_node_rotate_left(node);
- 
-    if (balance_factor > 1 && _avl_node_balance_factor(node->left) < 0) {
-        node->left =  _avl_node_rotate_left(node->left);
-        return _avl_node_rotate_right(node);
-    }
- 
-    if (balance_factor < -1 && _avl_node_balance_factor(node->right) > 0) {
-        node->right = _avl_node_rotate_right(node->right);
-        return _avl_node_rotate_left(node);
-    }
+		if(index < left) {
+			node = node->left;
+		} else {
+			index -= left + 1;
+			node = node->right;
+		}
+	}
 
-	return node;
+	return NULL;
 }
 
-void avl_tree_erase(avl_tree_t* tree, void* key) {
+const void* avl_select(avl_tree_t* tree, size_t index) {
 	if(tree == NULL)
-		return;
-	tree->root = _avl_node_erase(tree, tree->root, key);
+		return NULL;
+
+	avl_node_t* node = _avl_select(tree, index, NULL);
+	if(node == NULL)
+		return NULL;
+
+	return NODE_KEY(tree, node);
 }
 
 const void* avl_tree_search(avl_tree_t* tree, void* key) {
@@ -290,7 +433,7 @@ const void* avl_tree_search(avl_tree_t* tree, void* key) {
 	if(node == NULL)
 		return NULL;
 
-	int diff = tree->comparation(key, node->key);
+	int diff = tree->comparation(key, NODE_KEY(tree, node));
 
 	while(diff != 0) {
 		if(diff < 0)
@@ -298,44 +441,95 @@ const void* avl_tree_search(avl_tree_t* tree, void* key) {
 		else
 			node = node->right;
 		if(node) 
-			diff = tree->comparation(key, node->key);
+			diff = tree->comparation(key, NODE_KEY(tree, node));
 		else
 			return NULL;
 	}
 
-	return node->data;
+	return NODE_DATA(tree, node);
 }
 
+// nodes are taken in key order, so the copy is laid out in memory the way it is walked
 avl_node_t* _avl_node_copy(avl_tree_t* tree, avl_node_t* node) {
 	if(node == NULL)
 		return NULL;
 
-	avl_node_t* copy = _avl_node_new(tree, node->key, node->data);
-	if(copy == NULL) {
-		return NULL;
-	}
-
-	copy->height = node->height;
+	avl_node_t* left = _avl_node_copy(tree, node->left);
 
-	copy->left = _avl_node_copy(tree, node->left);
+	avl_node_t* copy = _avl_pool_alloc(tree);
+	memcpy(copy, node, tree->node_size);
+	copy->left = left;
 	copy->right = _avl_node_copy(tree, node->right);
 
 	return copy;
 }
 
 avl_tree_t* avl_tree_copy(avl_tree_t* tree) {
+	if(tree == NULL)
+		return NULL;
+
 	avl_tree_t* copy = avl_tree_init(tree->data_size, tree->key_size, tree->comparation);
+	if(copy == NULL)
+		return NULL;
 
-	copy->root = _avl_node_copy(copy, tree->root);
+	if(_avl_pool_reserve(copy, tree->count) != OK) {
+		avl_tree_delete(copy);
+		return NULL;
+	}
 
+	copy->root = _avl_node_copy(copy, tree->root);
 	copy->count = tree->count;
 
 	return copy;
 }
 
+// balanced subtree over the sorted entries [begin, end), middle entry at the root
+avl_node_t* _avl_node_from_sorted(avl_tree_t* tree, const char* keys, const char* data, size_t begin, size_t end) {
+	if(begin == end)
+		return NULL;
+
+	size_t middle = begin + (end - begin) / 2;
+	avl_node_t* left = _avl_node_from_sorted(tree, keys, data, begin, middle);
+
+	avl_node_t* node = _avl_node_new(tree, keys + middle * tree->key_size, data + middle * tree->data_size);
+	node->left = left;
+	node->right = _avl_node_from_sorted(tree, keys, data, middle + 1, end);
+	_avl_node_update(node);
+
+	return node;
+}
+
+avl_tree_t* avl_tree_from_sorted(unsigned int data_size, unsigned int key_size, int (*comparation)(const void*, const void*),
+	const void* keys, const void* data, size_t count) {
+	if(count > 0 && (keys == NULL || data == NULL))
+		return NULL;
+
+	for(size_t i = 1; i < count; i++) {
+		if(comparation((const char*)keys + (i - 1) * key_size, (const char*)keys + i * key_size) >= 0) {
+			printf("\n[avl->avl_tree_from_sorted]: Keys are not sorted in strictly increasing order!");
+			printf(" Returned NULL\n");
+			return NULL;
+		}
+	}
+
+	avl_tree_t* tree = avl_tree_init(data_size, key_size, comparation);
+	if(tree == NULL)
+		return NULL;
+
+	if(_avl_pool_reserve(tree, count) != OK) {
+		avl_tree_delete(tree);
+		return NULL;
+	}
+
+	tree->root = _avl_node_from_sorted(tree, keys, data, 0, count);
+	tree->count = count;
+
+	return tree;
+}
+
 void avl_tree_clear(avl_tree_t* tree) {
 	if(tree) {
-		_avl_node_delete(tree->root);
+		_avl_pool_release(&tree->pool);
 		tree->count = 0;
 		tree->root = NULL;
 	}
@@ -345,23 +539,10 @@ void avl_tree_swap(avl_tree_t* a, avl_tree_t* b) {
 	if(a == NULL || b == NULL)
 		return;
 
-	avl_node_t* root_a = a->root;
-	unsigned int data_size_a = a->data_size;
-	unsigned int key_size_a = a->key_size;
-	unsigned int count_a = a->count;
-	int (*comparation_a)(const void*, const void*) = a->comparation;
-
-	a->root = b->root;
-	a->data_size = b->data_size;
-	a->key_size = b->key_size;
-	a->count = b->count;
-	a->comparation = b->comparation;
-
-	b->root = root_a;
-	b->data_size = data_size_a;
-	b->key_size = key_size_a;
-	b->count = count_a;
-	b->comparation = comparation_a;
+	// the nodes only point to each other, so the pools move with the trees
+	avl_tree_t tmp = *a;
+	*a = *b;
+	*b = tmp;
 }
 
 
@@ -375,7 +556,7 @@ avl_node_t* _avl_lower_bound(avl_tree_t* tree, void* key) {
 	int diff = 0;
 
 	while (node != NULL) {
-		diff = tree->comparation(key, node->key);
+		diff = tree->comparation(key, NODE_KEY(tree, node));
 		if (diff == 0) {
 			return node;
 		}
@@ -402,5 +583,160 @@ const void* avl_lower_bound(avl_tree_t* tree, void* key) {
 		return NULL;
 	}
 
-	return node->key;
-}
\ No newline at end of file
+	return NODE_KEY(tree, node);
+}
+
+// CURSORS
+
+int avl_cursor_first(avl_tree_t* tree, avl_cursor_t* cursor) {
+	if(cursor == NULL)
+		return 0;
+
+	cursor->tree = tree;
+	cursor->depth = 0;
+
+	for(avl_node_t* node = tree ? tree->root : NULL; node; node = node->left)
+		cursor->path[cursor->depth++] = node;
+
+	return cursor->depth > 0;
+}
+
+int avl_cursor_last(avl_tree_t* tree, avl_cursor_t* cursor) {
+	if(cursor == NULL)
+		return 0;
+
+	cursor->tree = tree;
+	cursor->depth = 0;
+
+	for(avl_node_t* node = tree ? tree->root : NULL; node; node = node->right)
+		cursor->path[cursor->depth++] = node;
+
+	return cursor->depth > 0;
+}
+
+int avl_cursor_seek(avl_tree_t* tree, avl_cursor_t* cursor, const void* key) {
+	if(cursor == NULL)
+		return 0;
+
+	cursor->tree = tree;
+	cursor->depth = 0;
+
+	if(tree == NULL || key == NULL)
+		return 0;
+
+	// the path is kept up to the last node where the search went left,
+	// which is the smallest key bigger than the searched one
+	int found = 0;
+	int depth = 0;
+	avl_node_t* node = tree->root;
+
+	while(node) {
+		cursor->path[depth++] = node;
+
+		int diff = tree->comparation(key, NODE_KEY(tree, node));
+		if(diff == 0) {
+			found = depth;
+			break;
+		}
+
+		if(diff < 0) {
+			found = depth;
+			node = node->left;
+		} else {
+			node = node->right;
+		}
+	}
+
+	cursor->depth = found;
+
+	return found > 0;
+}
+
+int avl_cursor_select(avl_tree_t* tree, avl_cursor_t* cursor, size_t index) {
+	if(cursor == NULL)
+		return 0;
+
+	cursor->tree = tree;
+	cursor->depth = 0;
+
+	if(tree == NULL)
+		return 0;
+
+	return _avl_select(tree, index, cursor) != NULL;
+}
+
+int avl_cursor_next(avl_cursor_t* cursor) {
+	if(cursor == NULL || cursor->depth == 0)
+		return 0;
+
+	avl_node_t* node = cursor->path[cursor->depth - 1];
+
+	if(node->right) {
+		for(node = node->right; node; node = node->left)
+			cursor->path[cursor->depth++] = node;
+		return 1;
+	}
+
+	// climb while coming from a right child
+	while(cursor->depth > 1 && cursor->path[cursor->depth - 2]->right == cursor->path[cursor->depth - 1])
+		cursor->depth--;
+	cursor->depth--;
+
+	return cursor->depth > 0;
+}
+
+int avl_cursor_prev(avl_cursor_t* cursor) {
+	if(cursor == NULL || cursor->depth == 0)
+		return 0;
+
+	avl_node_t* node = cursor->path[cursor->depth - 1];
+
+	if(node->left) {
+		for(node = node->left; node; node = node->right)
+			cursor->path[cursor->depth++] = node;
+		return 1;
+	}
+
+	// climb while coming from a left child
+	while(cursor->depth > 1 && cursor->path[cursor->depth - 2]->left == cursor->path[cursor->depth - 1])
+		cursor->depth--;
+	cursor->depth--;
+
+	return cursor->depth > 0;
+}
+
+const void* avl_cursor_key(avl_cursor_t* cursor) {
+	if(cursor == NULL || cursor->depth == 0)
+		return NULL;
+	return NODE_KEY(cursor->tree, cursor->path[cursor->depth - 1]);
+}
+
+const void* avl_cursor_data(avl_cursor_t* cursor) {
+	if(cursor == NULL || cursor->depth == 0)
+		return NULL;
+	return NODE_DATA(cursor->tree, cursor->path[cursor->depth - 1]);
+}
+
+size_t avl_range_scan(avl_tree_t* tree, const void* lo, const void* hi,
+		int (*callback)(const void* key, const void* data, void* arg), void* arg) {
+	if(tree == NULL || callback == NULL)
+		return 0;
+
+	avl_cursor_t cursor;
+	int valid = lo ? avl_cursor_seek(tree, &cursor, lo) : avl_cursor_first(tree, &cursor);
+	size_t calls = 0;
+
+	while(valid) {
+		const void* key = avl_cursor_key(&cursor);
+		if(hi && tree->comparation(key, hi) > 0)
+			break;
+
+		calls++;
+		if(callback(key, avl_cursor_data(&cursor), arg))
+			break;
+
+		valid = avl_cursor_next(&cursor);
+	}
+
+	return calls;
+}
@@ -11,11 +11,17 @@ One may work better on some systems then the other
 // Implementation #1 ==================================================================================
 
 
+#define AT(heap, i) ((char*)(heap)->data + (i) * (heap)->data_size)
+
+// the buffer holds capacity + 1 slots, the last one is scratch space for sifting
+#define SCRATCH(heap) AT(heap, (heap)->capacity)
+
+
 clib_exit_code_t inc_cap(bheap_t* heap, size_t count) {
 	if(count == 0)
 		return OK;
 
-	void* tmp = realloc(heap->data, (count + heap->capacity) * heap->data_size);
+	void* tmp = realloc(heap->data, (count + heap->capacity + 1) * heap->data_size);
 	if(tmp == NULL)
 		return OUT_OF_MEM;
 
@@ -25,22 +31,63 @@ clib_exit_code_t inc_cap(bheap_t* heap, size_t count) {
 	return OK;
 }
 
+// places elem, which must not live in the heap, at the hole it and moves it up,
+// every parent it passes moves down once
+static void _bheap_sift_up(bheap_t* heap, size_t it, const void* elem) {
+	while(it != 0) {
+		size_t parent = (it - 1) / 2;
+		if(!heap->compare(AT(heap, parent), elem))
+			break;
+
+		memcpy(AT(heap, it), AT(heap, parent), heap->data_size);
+		it = parent;
+	}
+
+	memcpy(AT(heap, it), elem, heap->data_size);
+}
+
+// places elem, which must not live in the heap, at the hole it and moves it down
+static void _bheap_sift_down(bheap_t* heap, size_t it, const void* elem) {
+	size_t child;
+
+	while((child = 2 * it + 1) < heap->count) {
+		if(child + 1 < heap->count && heap->compare(AT(heap, child), AT(heap, child + 1)))
+			child++;
+		if(!heap->compare(elem, AT(heap, child)))
+			break;
+
+		memcpy(AT(heap, it), AT(heap, child), heap->data_size);
+		it = child;
+	}
+
+	memcpy(AT(heap, it), elem, heap->data_size);
+}
+
+// bottom up, every element is sifted down from the last parent to the root
+static void _bheap_heapify(bheap_t* heap) {
+	for(size_t i = heap->count / 2; i-- > 0;) {
+		memcpy(SCRATCH(heap), AT(heap, i), heap->data_size);
+		_bheap_sift_down(heap, i, SCRATCH(heap));
+	}
+}
+
 bheap_t* bheap_init(size_t capacity, size_t data_size, uint8_t (*compare)(const void*, const void*)) {
 	bheap_t* heap = malloc(sizeof(*heap));
 	if(heap == NULL) {
-		printf("\n[bheap2->bheap_init]: Not enough memory to create heap!\n");
+		printf("\n[bheap->bheap_init]: Not enough memory to create heap!\n");
 		return NULL;
 	}
 
 	capacity = _max(capacity, 1);
 
-	heap->data = calloc(capacity, data_size);
+	heap->data = calloc(capacity + 1, data_size);
 	if(heap->data == NULL) {
-		printf("\n[bheap2->bheap_init]: Not enough memory to create heap!\n");
+		printf("\n[bheap->bheap_init]: Not enough memory to create heap!\n");
 		free(heap);
 		return NULL;
 	}
 
+	heap->capacity = capacity;
 	heap->count = 0;
 	heap->data_size = data_size;
 	heap->compare = compare;
@@ -49,9 +96,29 @@ bheap_t* bheap_init(size_t capacity, size_t data_size, uint8_t (*compare)(const
 }
 
 
+bheap_t* bheap_from_array(const void* array, size_t count, size_t data_size, uint8_t (*compare)(const void*, const void*)) {
+	if(array == NULL && count > 0) {
+		printf("\n[bheap->bheap_from_array]: Null reference to array! Returning NULL.\n");
+		return NULL;
+	}
+
+	bheap_t* heap = bheap_init(count, data_size, compare);
+	if(heap == NULL)
+		return NULL;
+
+	if(count > 0)
+		memcpy(heap->data, array, count * data_size);
+	heap->count = count;
+
+	_bheap_heapify(heap);
+
+	return heap;
+}
+
+
 clib_exit_code_t bheap_delete(bheap_t* heap) {
 	if(heap == NULL) {
-		printf("\n[bheap2->bheap_delete]: Null reference to heap!\n");
+		printf("\n[bheap->bheap_delete]: Null reference to heap!\n");
 		return NULL_REF;
 	}
 
@@ -65,16 +132,16 @@ clib_exit_code_t bheap_delete(bheap_t* heap) {
 
 clib_exit_code_t bheap_clear(bheap_t* heap) {
 	if(heap == NULL) {
-		printf("\n[bheap2->bheap_clear]: Null reference to heap!\n");
+		printf("\n[bheap->bheap_clear]: Null reference to heap!\n");
 		return NULL_REF;
 	}
 
 	if(heap->data) {
 		free(heap->data);
-		heap->data = calloc(1, heap->data_size);
+		heap->data = calloc(2, heap->data_size);
 
 		if(heap->data == NULL) {
-			printf("\n[bheap2->bheap_clear]: Could not reinitialize the heap! Deleting it!\n");
+			printf("\n[bheap->bheap_clear]: Could not reinitialize the heap! Deleting it!\n");
 			bheap_delete(heap);
 			return UNSAFE;
 		}
@@ -89,24 +156,13 @@ clib_exit_code_t bheap_clear(bheap_t* heap) {
 
 clib_exit_code_t bheap_swap(bheap_t* heap_a, bheap_t* heap_b) {
 	if(heap_a == NULL || heap_b == NULL) {
-		printf("\n[bheap2->bheap_swap]: Null reference to heap!\n");
+		printf("\n[bheap->bheap_swap]: Null reference to heap!\n");
 		return NULL_REF;
 	}
 
-	void* a_data = heap_a->data;
-	size_t a_cap = heap_a->capacity;
-	size_t a_count = heap_a->count;
-	size_t a_data_size = heap_a->data_size;
-
-	heap_a->data = heap_b->data;
-	heap_a->capacity = heap_b->capacity;
-	heap_a->count = heap_b->count;
-	heap_a->data_size = heap_b->count;
-
-	heap_b->data = a_data;
-	heap_b->capacity = a_cap;
-	heap_b->count = a_count;
-	heap_b->data_size = a_data_size;
+	bheap_t tmp = *heap_a;
+	*heap_a = *heap_b;
+	*heap_b = tmp;
 
 	return OK;
 }
@@ -114,19 +170,18 @@ clib_exit_code_t bheap_swap(bheap_t* heap_a, bheap_t* heap_b) {
 
 bheap_t* bheap_copy(bheap_t* heap){
 	if(heap == NULL) {
-		printf("\n[bheap2->bheap_copy]: Null reference to heap! Returning NULL.\n");
+		printf("\n[bheap->bheap_copy]: Null reference to heap! Returning NULL.\n");
 		return NULL;
 	}
 
 	bheap_t* copy = bheap_init(heap->capacity, heap->data_size, heap->compare);
 	if(copy == NULL){
-		printf("\n[bheap2->bheap_copy]: Not enough memory to create heap! Returning NULL.\n");
+		printf("\n[bheap->bheap_copy]: Not enough memory to create heap! Returning NULL.\n");
 		return NULL;
 	}
 
-	for(size_t i = 0; i < heap->count; i++) {
-		memcpy((char*)(copy->data) + i * heap->data_size, (char*)(heap->data) + i * heap->data_size, heap->data_size);
-	}
+	memcpy(copy->data, heap->data, heap->count * heap->data_size);
+	copy->count = heap->count;
 
 	return copy;
 }
@@ -134,96 +189,84 @@ bheap_t* bheap_copy(bheap_t* heap){
 
 clib_exit_code_t bheap_insert(bheap_t* heap, void* data) {
 	if(heap == NULL || data == NULL) {
-		printf("\n[bheap2->bheap_insert]: Null reference to heap or data.\n");
+		printf("\n[bheap->bheap_insert]: Null reference to heap or data.\n");
 		return NULL_REF;
 	}
- 
+
 	if(heap->count + 1 > heap->capacity) {
-		clib_exit_code_t err = inc_cap(heap, 2);
+		clib_exit_code_t err = inc_cap(heap, heap->capacity);
 		if(err != OK){
-			printf("\n[bheap2->bheap_insert]: Not enough memory to create heap!\n");
+			printf("\n[bheap->bheap_insert]: Not enough memory to create heap!\n");
 			return err;
 		}
 	}
- 
-	memcpy((char*)heap->data + heap->count * heap->data_size, data, heap->data_size);
-	heap->count++;
- 
-	size_t it = heap->count - 1;
-	void* tmp = malloc(heap->data_size);
-	if(tmp == NULL) {
-		printf("\n[bheap2->bheap_insert]: Not enough memory to performe action!\n");
-		heap->count--;
-		return OUT_OF_MEM;
-	}
- 
-	while(it != 0 && heap->compare((void*)((char*)heap->data + ((it - 1) / 2) * heap->data_size), (void*)((char*)heap->data + it * heap->data_size))) {
-		memcpy(tmp, (char*)(heap->data) + it * heap->data_size, heap->data_size);
-		memcpy((char*)(heap->data) + it * heap->data_size, (char*)(heap->data) + ((it - 1) / 2) * heap->data_size, heap->data_size);
-		memcpy((char*)(heap->data) + ((it - 1) / 2) * heap->data_size, tmp, heap->data_size);
-		it = (it - 1) / 2;
-	}
- 
+
+	_bheap_sift_up(heap, heap->count++, data);
+
 	return OK;
 }
 
 
 clib_exit_code_t bheap_pop(bheap_t* heap) {
 	if(heap == NULL) {
-		printf("\n[bheap2->bheap_pop]: Null reference to heap!\n");
+		printf("\n[bheap->bheap_pop]: Null reference to heap!\n");
 		return NULL_REF;
 	}
- 
+
 	if(heap->count <= 1){
 		heap->count = 0;
 		return OK;
 	}
- 	
-	void* tmp = malloc(heap->data_size);
-	if(tmp == NULL){
-		printf("\n[bheap2->bheap_pop]: Not enough memory to performe action!\n");
-		return OUT_OF_MEM;
-	}
-	memcpy(tmp, heap->data, heap->data_size);
-	memcpy(heap->data, (char*)heap->data + (heap->count - 1) * heap->data_size, heap->data_size);
-	memcpy((char*)heap->data + (heap->count - 1) * heap->data_size, tmp, heap->data_size);
+
+	// the last element is outside the heap once count drops, so it can fill the hole directly
 	heap->count--;
- 
-	size_t it = 0;
- 
-	while(it < heap->count){
-		size_t left = 2 * it + 1;
-		size_t right = 2 * it + 2;
- 
-		memcpy(tmp, (char*)heap->data + it * heap->data_size, heap->data_size);
-		size_t next = it;
- 
-		if(left < heap->count && heap->compare(tmp, (void*)((char*)heap->data + left * heap->data_size))) {
-			memcpy(tmp, (char*)heap->data + left * heap->data_size, heap->data_size);
-			next = left;
-		}
-		if(right < heap->count && heap->compare(tmp, (void*)((char*)heap->data + right * heap->data_size))) {
-			memcpy(tmp, (char*)heap->data + right * heap->data_size, heap->data_size);
-			next = right;
-		}
- 
-		if(next == it) {
-			break;
-		}
- 
-		memcpy((char*)heap->data + next * heap->data_size, (char*)heap->data + it * heap->data_size, heap->data_size);
- 		memcpy((char*)heap->data + it * heap->data_size, tmp, heap->data_size);
+	_bheap_sift_down(heap, 0, AT(heap, heap->count));
 
-		it = next;
+	return OK;
+}
+
+
+clib_exit_code_t bheap_push_pop(bheap_t* heap, const void* data, void* out) {
+	if(heap == NULL || data == NULL || out == NULL) {
+		printf("\n[bheap->bheap_push_pop]: Null reference to heap, data or out!\n");
+		return NULL_REF;
 	}
- 
+
+	// data would come straight back out, the heap is left untouched
+	if(heap->count == 0 || !heap->compare(data, heap->data)) {
+		memmove(out, data, heap->data_size);
+		return OK;
+	}
+
+	// the old top goes through scratch so out may be the same memory as data
+	memcpy(SCRATCH(heap), heap->data, heap->data_size);
+	_bheap_sift_down(heap, 0, data);
+	memcpy(out, SCRATCH(heap), heap->data_size);
+
+	return OK;
+}
+
+
+clib_exit_code_t bheap_replace_top(bheap_t* heap, const void* data) {
+	if(heap == NULL || data == NULL) {
+		printf("\n[bheap->bheap_replace_top]: Null reference to heap or data!\n");
+		return NULL_REF;
+	}
+
+	if(heap->count == 0)
+		return OUT_OF_BOUNDS;
+
+	// data may be an element of the heap, for example the top itself
+	memcpy(SCRATCH(heap), data, heap->data_size);
+	_bheap_sift_down(heap, 0, SCRATCH(heap));
+
 	return OK;
 }
 
 
 const void* bheap_get_top(bheap_t* heap) {
 	if(heap == NULL){
-		printf("\n[bheap2->bheap_insert]: Null reference to heap! Returning NULL.\n");
+		printf("\n[bheap->bheap_get_top]: Null reference to heap! Returning NULL.\n");
 		return NULL;
 	}
 
@@ -238,19 +281,14 @@ clib_exit_code_t bheap_sort(void* array, size_t elem_size, size_t begin, size_t
 		return NULL_REF;
 	}
 
-	size_t num = end - begin + 1;
-	bheap_t* heap = bheap_init(num, elem_size, compare);
+	char* range = (char*)array + begin * elem_size;
+	bheap_t* heap = bheap_from_array(range, end - begin + 1, elem_size, compare);
 	if(heap == NULL) {
 		return OUT_OF_MEM;
 	}
 
 	for(size_t i = begin; i <= end; i++) {
-		bheap_insert(heap, (void*)((char*)array + i * elem_size));
-	}
-
-	for(size_t i = begin; i <= end; i++) {
-		const void* top = bheap_get_top(heap);
-		memcpy((char*)array + i * elem_size, top, elem_size);
+		memcpy((char*)array + i * elem_size, heap->data, elem_size);
 		bheap_pop(heap);
 	}
 
@@ -272,10 +310,10 @@ clib_exit_code_t inc_cap2(bheap2_t* heap, size_t factor){
 		}
  
 		for(int i = 0; i < factor; i++){
-			heap->data[i] = malloc(sizeof(heap->data_size));
+			heap->data[i] = malloc(heap->data_size);
 			if(NULL == heap->data[i]){
-				for(int j = 0; j <= i; j++){
-					free(heap->data[i]);
+				for(int j = 0; j < i; j++){
+					free(heap->data[j]);
 				}
 				free(heap->data);
 				heap->data = NULL;
@@ -299,10 +337,10 @@ clib_exit_code_t inc_cap2(bheap2_t* heap, size_t factor){
 	}
  
 	for(int i = heap->capacity; i < factor * heap->capacity; i++){
-		new_array[i] = malloc(sizeof(heap->data_size));
+		new_array[i] = malloc(heap->data_size);
 		if(NULL == new_array[i]){
-			for(int j = 0; j <= i; j++){
-				free(new_array[i]);
+			for(int j = heap->capacity; j < i; j++){
+				free(new_array[j]);
 			}
 			free(new_array);
  
@@ -384,7 +422,7 @@ clib_exit_code_t bheap2_clear(bheap2_t* heap) {
 }
  
 bheap2_t* bheap2_copy(bheap2_t* heap){
-	bheap2_t* copy = bheap2_init(heap->data_size, heap->capacity, heap->compare);
+	bheap2_t* copy = bheap2_init(heap->capacity, heap->data_size, heap->compare);
 	if(NULL == copy){
 		return NULL;
 	}
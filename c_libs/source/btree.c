@@ -0,0 +1,581 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+A B+tree implementation in C
+*/
+
+#include "../include/btree.h"
+
+#define BTREE_CACHE_LINE 64
+#define BTREE_MIN_FANOUT 4
+
+#define CHILDREN(node) ((btree_node_t**)(node)->payload)
+#define INNER_KEY(tree, node, i) ((char*)(node) + (tree)->inner_keys + (size_t)(i) * (tree)->key_size)
+#define LEAF_KEY(tree, node, i) ((char*)(node) + (tree)->leaf_keys + (size_t)(i) * (tree)->key_size)
+#define LEAF_DATA(tree, node, i) ((char*)(node) + (tree)->leaf_data + (size_t)(i) * (tree)->data_size)
+
+// fewest keys a node other than the root may hold
+#define MIN_KEYS(tree, node) ((node)->leaf ? (tree)->leaf_max / 2 : (tree)->inner_max / 2)
+
+
+static size_t _btree_align_up(size_t offset, size_t align) {
+	return (offset + align - 1) / align * align;
+}
+
+// largest power of two dividing size, up to the pointer size
+static size_t _btree_align_of(size_t size) {
+	size_t align = 1;
+	while(align < sizeof(void*) && size % (2 * align) == 0)
+		align *= 2;
+	return align;
+}
+
+// scratch layout: children, keys, data, separator
+static btree_node_t** _scratch_children(btree_t* tree) {
+	return tree->scratch;
+}
+
+static char* _scratch_keys(btree_t* tree) {
+	return (char*)tree->scratch + (tree->inner_max + 2) * sizeof(btree_node_t*);
+}
+
+static char* _scratch_data(btree_t* tree) {
+	return _scratch_keys(tree) + (size_t)(_max(tree->inner_max, tree->leaf_max) + 1) * tree->key_size;
+}
+
+static char* _scratch_separator(btree_t* tree) {
+	return _scratch_data(tree) + (size_t)(tree->leaf_max + 1) * tree->data_size;
+}
+
+btree_t* btree_init(unsigned int data_size, unsigned int key_size, int (*comparation)(const void*, const void*)) {
+	if(key_size == 0 || comparation == NULL)
+		return NULL;
+
+	btree_t* tree = malloc(sizeof(btree_t));
+	if(tree == NULL) {
+		printf("\n[btree->btree_init]: Not enough memory to create btree!");
+		printf(" Returned NULL\n");
+		return NULL;
+	}
+
+	size_t header = offsetof(btree_node_t, payload);
+	size_t key_align = _btree_align_of(key_size);
+	size_t data_align = _btree_align_of(data_size);
+
+	// as many entries as fit in BTREE_NODE_BYTES, but never a degenerate fanout
+	tree->inner_max = (BTREE_NODE_BYTES - header - sizeof(btree_node_t*)) / (sizeof(btree_node_t*) + key_size);
+	tree->inner_max = _min(_max(tree->inner_max, BTREE_MIN_FANOUT), 0xFFFF);
+	tree->leaf_max = (BTREE_NODE_BYTES - header) / (key_size + data_size);
+	tree->leaf_max = _min(_max(tree->leaf_max, BTREE_MIN_FANOUT), 0xFFFF);
+
+	tree->inner_keys = _btree_align_up(header + (tree->inner_max + 1) * sizeof(btree_node_t*), key_align);
+	tree->inner_size = _btree_align_up(tree->inner_keys + tree->inner_max * key_size, BTREE_CACHE_LINE);
+	tree->leaf_keys = _btree_align_up(header, key_align);
+	tree->leaf_data = _btree_align_up(tree->leaf_keys + tree->leaf_max * key_size, data_align);
+	tree->leaf_size = _btree_align_up(tree->leaf_data + tree->leaf_max * data_size, BTREE_CACHE_LINE);
+
+	tree->scratch = malloc((tree->inner_max + 2) * sizeof(btree_node_t*)
+		+ (_max(tree->inner_max, tree->leaf_max) + 2) * key_size
+		+ (tree->leaf_max + 1) * data_size);
+	if(tree->scratch == NULL) {
+		printf("\n[btree->btree_init]: Not enough memory to create btree!");
+		printf(" Returned NULL\n");
+		free(tree);
+		return NULL;
+	}
+
+	tree->root = NULL;
+	tree->count = 0;
+	tree->height = 0;
+	tree->data_size = data_size;
+	tree->key_size = key_size;
+	tree->comparation = comparation;
+
+	return tree;
+}
+
+size_t btree_count(btree_t* tree) {
+	if(tree)
+		return tree->count;
+	return 0;
+}
+
+static btree_node_t* _btree_node_new(btree_t* tree, int leaf) {
+	btree_node_t* node = aligned_alloc(BTREE_CACHE_LINE, leaf ? tree->leaf_size : tree->inner_size);
+	if(node == NULL)
+		return NULL;
+
+	node->next = NULL;
+	node->count = 0;
+	node->leaf = leaf;
+
+	return node;
+}
+
+static void _btree_node_delete(btree_node_t* node) {
+	if(node == NULL)
+		return;
+
+	if(!node->leaf) {
+		for(int i = 0; i <= node->count; i++)
+			_btree_node_delete(CHILDREN(node)[i]);
+	}
+
+	free(node);
+}
+
+void btree_delete(btree_t* tree) {
+	if(tree) {
+		_btree_node_delete(tree->root);
+		free(tree->scratch);
+		free(tree);
+	}
+}
+
+void btree_clear(btree_t* tree) {
+	if(tree) {
+		_btree_node_delete(tree->root);
+		tree->root = NULL;
+		tree->count = 0;
+		tree->height = 0;
+	}
+}
+
+void btree_swap(btree_t* a, btree_t* b) {
+	if(a == NULL || b == NULL)
+		return;
+
+	btree_t tmp = *a;
+	*a = *b;
+	*b = tmp;
+}
+
+
+// SEARCH
+
+// first index in keys[0..count) whose key is bigger than key (upper) or not smaller (lower)
+static size_t _btree_bound(btree_t* tree, const char* keys, size_t count, const void* key, int upper) {
+	size_t base = 0;
+	while(count > 0) {
+		size_t half = count / 2;
+		int diff = tree->comparation(keys + (base + half) * tree->key_size, key);
+
+		if(diff < 0 || (upper && diff == 0)) {
+			base += half + 1;
+			count -= half + 1;
+		} else {
+			count = half;
+		}
+	}
+
+	return base;
+}
+
+// child of an inner node that may hold key
+static size_t _btree_child_index(btree_t* tree, btree_node_t* node, const void* key) {
+	return _btree_bound(tree, INNER_KEY(tree, node, 0), node->count, key, 1);
+}
+
+static btree_node_t* _btree_find_leaf(btree_t* tree, const void* key) {
+	btree_node_t* node = tree->root;
+
+	while(node && !node->leaf)
+		node = CHILDREN(node)[_btree_child_index(tree, node, key)];
+
+	return node;
+}
+
+const void* btree_search(btree_t* tree, void* key) {
+	if(tree == NULL || key == NULL)
+		return NULL;
+
+	btree_node_t* leaf = _btree_find_leaf(tree, key);
+	if(leaf == NULL)
+		return NULL;
+
+	size_t pos = _btree_bound(tree, LEAF_KEY(tree, leaf, 0), leaf->count, key, 0);
+	if(pos == leaf->count || tree->comparation(LEAF_KEY(tree, leaf, pos), key) != 0)
+		return NULL;
+
+	return LEAF_DATA(tree, leaf, pos);
+}
+
+// leaf and position of the first key not smaller than key, leaf is NULL if there is none
+static btree_node_t* _btree_lower(btree_t* tree, const void* key, size_t* pos) {
+	btree_node_t* leaf = _btree_find_leaf(tree, key);
+	if(leaf == NULL)
+		return NULL;
+
+	*pos = _btree_bound(tree, LEAF_KEY(tree, leaf, 0), leaf->count, key, 0);
+
+	// every key of this leaf is smaller, the answer starts the next one
+	if(*pos == leaf->count) {
+		leaf = leaf->next;
+		*pos = 0;
+	}
+
+	return leaf;
+}
+
+const void* btree_lower_bound(btree_t* tree, void* key) {
+	if(tree == NULL || key == NULL)
+		return NULL;
+
+	size_t pos = 0;
+	btree_node_t* leaf = _btree_lower(tree, key, &pos);
+	if(leaf == NULL)
+		return NULL;
+
+	return LEAF_KEY(tree, leaf, pos);
+}
+
+const void* btree_min_key(btree_t* tree) {
+	if(tree == NULL || tree->root == NULL)
+		return NULL;
+
+	btree_node_t* node = tree->root;
+	while(!node->leaf)
+		node = CHILDREN(node)[0];
+
+	return LEAF_KEY(tree, node, 0);
+}
+
+const void* btree_max_key(btree_t* tree) {
+	if(tree == NULL || tree->root == NULL)
+		return NULL;
+
+	btree_node_t* node = tree->root;
+	while(!node->leaf)
+		node = CHILDREN(node)[node->count];
+
+	return LEAF_KEY(tree, node, node->count - 1);
+}
+
+size_t btree_range_scan(btree_t* tree, const void* lo, const void* hi,
+		int (*callback)(const void* key, const void* data, void* arg), void* arg) {
+	if(tree == NULL || callback == NULL || tree->root == NULL)
+		return 0;
+
+	size_t pos = 0;
+	btree_node_t* leaf = NULL;
+
+	if(lo) {
+		leaf = _btree_lower(tree, lo, &pos);
+	} else {
+		leaf = tree->root;
+		while(!leaf->leaf)
+			leaf = CHILDREN(leaf)[0];
+	}
+
+	size_t calls = 0;
+	for(; leaf; leaf = leaf->next, pos = 0) {
+		for(; pos < leaf->count; pos++) {
+			const void* key = LEAF_KEY(tree, leaf, pos);
+			if(hi && tree->comparation(key, hi) > 0)
+				return calls;
+
+			calls++;
+			if(callback(key, LEAF_DATA(tree, leaf, pos), arg))
+				return calls;
+		}
+	}
+
+	return calls;
+}
+
+
+// INSERT
+
+// inserts key / data at pos of a leaf with room
+static void _btree_leaf_insert(btree_t* tree, btree_node_t* leaf, size_t pos, const void* key, const void* data) {
+	size_t tail = leaf->count - pos;
+
+	memmove(LEAF_KEY(tree, leaf, pos + 1), LEAF_KEY(tree, leaf, pos), tail * tree->key_size);
+	memmove(LEAF_DATA(tree, leaf, pos + 1), LEAF_DATA(tree, leaf, pos), tail * tree->data_size);
+	memcpy(LEAF_KEY(tree, leaf, pos), key, tree->key_size);
+	memcpy(LEAF_DATA(tree, leaf, pos), data, tree->data_size);
+	leaf->count++;
+}
+
+// inserts key at pos and child right after it, in an inner node with room
+static void _btree_inner_insert(btree_t* tree, btree_node_t* node, size_t pos, const void* key, btree_node_t* child) {
+	size_t tail = node->count - pos;
+
+	memmove(INNER_KEY(tree, node, pos + 1), INNER_KEY(tree, node, pos), tail * tree->key_size);
+	memmove(&CHILDREN(node)[pos + 2], &CHILDREN(node)[pos + 1], tail * sizeof(btree_node_t*));
+	memcpy(INNER_KEY(tree, node, pos), key, tree->key_size);
+	CHILDREN(node)[pos + 1] = child;
+	node->count++;
+}
+
+// splits a full leaf while inserting, the first key of right goes to the separator
+static void _btree_leaf_split(btree_t* tree, btree_node_t* leaf, btree_node_t* right, size_t pos, const void* key, const void* data) {
+	char* keys = _scratch_keys(tree);
+	char* values = _scratch_data(tree);
+	size_t total = leaf->count + 1;
+	size_t ks = tree->key_size, ds = tree->data_size;
+
+	memcpy(keys, LEAF_KEY(tree, leaf, 0), pos * ks);
+	memcpy(keys + pos * ks, key, ks);
+	memcpy(keys + (pos + 1) * ks, LEAF_KEY(tree, leaf, pos), (leaf->count - pos) * ks);
+	memcpy(values, LEAF_DATA(tree, leaf, 0), pos * ds);
+	memcpy(values + pos * ds, data, ds);
+	memcpy(values + (pos + 1) * ds, LEAF_DATA(tree, leaf, pos), (leaf->count - pos) * ds);
+
+	size_t left_count = total / 2;
+	memcpy(LEAF_KEY(tree, leaf, 0), keys, left_count * ks);
+	memcpy(LEAF_DATA(tree, leaf, 0), values, left_count * ds);
+	memcpy(LEAF_KEY(tree, right, 0), keys + left_count * ks, (total - left_count) * ks);
+	memcpy(LEAF_DATA(tree, right, 0), values + left_count * ds, (total - left_count) * ds);
+	leaf->count = left_count;
+	right->count = total - left_count;
+
+	right->next = leaf->next;
+	leaf->next = right;
+
+	memcpy(_scratch_separator(tree), LEAF_KEY(tree, right, 0), ks);
+}
+
+// splits a full inner node while inserting key / child, the middle key goes to the separator
+static void _btree_inner_split(btree_t* tree, btree_node_t* node, btree_node_t* right, size_t pos, btree_node_t* child) {
+	char* keys = _scratch_keys(tree);
+	btree_node_t** children = _scratch_children(tree);
+	size_t total = node->count + 1;
+	size_t ks = tree->key_size;
+
+	// the inserted key is the current separator
+	memcpy(keys, INNER_KEY(tree, node, 0), pos * ks);
+	memcpy(keys + pos * ks, _scratch_separator(tree), ks);
+	memcpy(keys + (pos + 1) * ks, INNER_KEY(tree, node, pos), (node->count - pos) * ks);
+	memcpy(children, CHILDREN(node), (pos + 1) * sizeof(btree_node_t*));
+	children[pos + 1] = child;
+	memcpy(children + pos + 2, &CHILDREN(node)[pos + 1], (node->count - pos) * sizeof(btree_node_t*));
+
+	size_t mid = total / 2;
+	memcpy(INNER_KEY(tree, node, 0), keys, mid * ks);
+	memcpy(CHILDREN(node), children, (mid + 1) * sizeof(btree_node_t*));
+	memcpy(INNER_KEY(tree, right, 0), keys + (mid + 1) * ks, (total - mid - 1) * ks);
+	memcpy(CHILDREN(right), children + mid + 1, (total - mid) * sizeof(btree_node_t*));
+	node->count = mid;
+	right->count = total - mid - 1;
+
+	memcpy(_scratch_separator(tree), keys + mid * ks, ks);
+}
+
+clib_exit_code_t btree_insert(btree_t* tree, void* key, void* data) {
+	if(tree == NULL || key == NULL || data == NULL) {
+		printf("\n[btree->btree_insert]: Null reference to btree!\n");
+		return NULL_REF;
+	}
+
+	if(tree->root == NULL) {
+		tree->root = _btree_node_new(tree, 1);
+		if(tree->root == NULL)
+			return OUT_OF_MEM;
+		tree->height = 1;
+	}
+
+	btree_node_t* path[BTREE_MAX_HEIGHT];
+	size_t index[BTREE_MAX_HEIGHT];
+	int depth = 0;
+
+	btree_node_t* node = tree->root;
+	while(!node->leaf) {
+		path[depth] = node;
+		index[depth] = _btree_child_index(tree, node, key);
+		node = CHILDREN(node)[index[depth++]];
+	}
+
+	size_t pos = _btree_bound(tree, LEAF_KEY(tree, node, 0), node->count, key, 0);
+	if(pos < node->count && tree->comparation(LEAF_KEY(tree, node, pos), key) == 0) {
+		memcpy(LEAF_DATA(tree, node, pos), data, tree->data_size);
+		return OK;
+	}
+
+	if(node->count < tree->leaf_max) {
+		_btree_leaf_insert(tree, node, pos, key, data);
+		tree->count++;
+		return OK;
+	}
+
+	// every split node needs a sibling, and a new root if the root splits too;
+	// they are allocated first so a failure leaves the tree untouched
+	int splits = 1;
+	while(splits <= depth && path[depth - splits]->count == tree->inner_max)
+		splits++;
+	int new_root = splits > depth;
+
+	btree_node_t* fresh[BTREE_MAX_HEIGHT + 1];
+	for(int i = 0; i < splits + new_root; i++) {
+		fresh[i] = _btree_node_new(tree, i == 0);
+		if(fresh[i] == NULL) {
+			while(i-- > 0)
+				free(fresh[i]);
+			return OUT_OF_MEM;
+		}
+	}
+
+	_btree_leaf_split(tree, node, fresh[0], pos, key, data);
+	tree->count++;
+
+	btree_node_t* right = fresh[0];
+	for(int i = 1; i < splits; i++) {
+		depth--;
+		_btree_inner_split(tree, path[depth], fresh[i], index[depth], right);
+		right = fresh[i];
+	}
+
+	if(new_root) {
+		btree_node_t* root = fresh[splits];
+		memcpy(INNER_KEY(tree, root, 0), _scratch_separator(tree), tree->key_size);
+		CHILDREN(root)[0] = tree->root;
+		CHILDREN(root)[1] = right;
+		root->count = 1;
+		tree->root = root;
+		tree->height++;
+	} else {
+		depth--;
+		_btree_inner_insert(tree, path[depth], index[depth], _scratch_separator(tree), right);
+	}
+
+	return OK;
+}
+
+
+// ERASE
+
+static void _btree_remove_entry(btree_t* tree, btree_node_t* leaf, size_t pos) {
+	size_t tail = leaf->count - pos - 1;
+
+	memmove(LEAF_KEY(tree, leaf, pos), LEAF_KEY(tree, leaf, pos + 1), tail * tree->key_size);
+	memmove(LEAF_DATA(tree, leaf, pos), LEAF_DATA(tree, leaf, pos + 1), tail * tree->data_size);
+	leaf->count--;
+}
+
+// removes separator pos and the child right after it
+static void _btree_remove_separator(btree_t* tree, btree_node_t* node, size_t pos) {
+	size_t tail = node->count - pos - 1;
+
+	memmove(INNER_KEY(tree, node, pos), INNER_KEY(tree, node, pos + 1), tail * tree->key_size);
+	memmove(&CHILDREN(node)[pos + 1], &CHILDREN(node)[pos + 2], tail * sizeof(btree_node_t*));
+	node->count--;
+}
+
+// moves the last entry of left to the front of node, left and node are children i - 1 and i of parent
+static void _btree_borrow_left(btree_t* tree, btree_node_t* parent, size_t i, btree_node_t* left, btree_node_t* node) {
+	char* separator = INNER_KEY(tree, parent, i - 1);
+
+	if(node->leaf) {
+		_btree_leaf_insert(tree, node, 0, LEAF_KEY(tree, left, left->count - 1), LEAF_DATA(tree, left, left->count - 1));
+		left->count--;
+		memcpy(separator, LEAF_KEY(tree, node, 0), tree->key_size);
+		return;
+	}
+
+	memmove(INNER_KEY(tree, node, 1), INNER_KEY(tree, node, 0), node->count * tree->key_size);
+	memmove(&CHILDREN(node)[1], &CHILDREN(node)[0], (node->count + 1) * sizeof(btree_node_t*));
+	memcpy(INNER_KEY(tree, node, 0), separator, tree->key_size);
+	CHILDREN(node)[0] = CHILDREN(left)[left->count];
+	node->count++;
+
+	memcpy(separator, INNER_KEY(tree, left, left->count - 1), tree->key_size);
+	left->count--;
+}
+
+// moves the first entry of right to the end of node, node and right are children i and i + 1 of parent
+static void _btree_borrow_right(btree_t* tree, btree_node_t* parent, size_t i, btree_node_t* node, btree_node_t* right) {
+	char* separator = INNER_KEY(tree, parent, i);
+
+	if(node->leaf) {
+		_btree_leaf_insert(tree, node, node->count, LEAF_KEY(tree, right, 0), LEAF_DATA(tree, right, 0));
+		_btree_remove_entry(tree, right, 0);
+		memcpy(separator, LEAF_KEY(tree, right, 0), tree->key_size);
+		return;
+	}
+
+	memcpy(INNER_KEY(tree, node, node->count), separator, tree->key_size);
+	CHILDREN(node)[node->count + 1] = CHILDREN(right)[0];
+	node->count++;
+
+	memcpy(separator, INNER_KEY(tree, right, 0), tree->key_size);
+	memmove(INNER_KEY(tree, right, 0), INNER_KEY(tree, right, 1), (right->count - 1) * tree->key_size);
+	memmove(&CHILDREN(right)[0], &CHILDREN(right)[1], right->count * sizeof(btree_node_t*));
+	right->count--;
+}
+
+// appends right to left, they are children i and i + 1 of parent
+static void _btree_merge(btree_t* tree, btree_node_t* parent, size_t i, btree_node_t* left, btree_node_t* right) {
+	if(left->leaf) {
+		memcpy(LEAF_KEY(tree, left, left->count), LEAF_KEY(tree, right, 0), right->count * tree->key_size);
+		memcpy(LEAF_DATA(tree, left, left->count), LEAF_DATA(tree, right, 0), right->count * tree->data_size);
+		left->count += right->count;
+		left->next = right->next;
+	} else {
+		memcpy(INNER_KEY(tree, left, left->count), INNER_KEY(tree, parent, i), tree->key_size);
+		memcpy(INNER_KEY(tree, left, left->count + 1), INNER_KEY(tree, right, 0), right->count * tree->key_size);
+		memcpy(&CHILDREN(left)[left->count + 1], CHILDREN(right), (right->count + 1) * sizeof(btree_node_t*));
+		left->count += right->count + 1;
+	}
+
+	free(right);
+	_btree_remove_separator(tree, parent, i);
+}
+
+void btree_erase(btree_t* tree, void* key) {
+	if(tree == NULL || key == NULL || tree->root == NULL)
+		return;
+
+	btree_node_t* path[BTREE_MAX_HEIGHT];
+	size_t index[BTREE_MAX_HEIGHT];
+	int depth = 0;
+
+	btree_node_t* node = tree->root;
+	while(!node->leaf) {
+		path[depth] = node;
+		index[depth] = _btree_child_index(tree, node, key);
+		node = CHILDREN(node)[index[depth++]];
+	}
+
+	size_t pos = _btree_bound(tree, LEAF_KEY(tree, node, 0), node->count, key, 0);
+	if(pos == node->count || tree->comparation(LEAF_KEY(tree, node, pos), key) != 0)
+		return;
+
+	_btree_remove_entry(tree, node, pos);
+	tree->count--;
+
+	// fix underflows bottom up, by borrowing from a sibling or merging with it
+	while(depth > 0 && node->count < MIN_KEYS(tree, node)) {
+		depth--;
+		btree_node_t* parent = path[depth];
+		size_t i = index[depth];
+		btree_node_t* left = i > 0 ? CHILDREN(parent)[i - 1] : NULL;
+		btree_node_t* right = i < parent->count ? CHILDREN(parent)[i + 1] : NULL;
+
+		if(left && left->count > MIN_KEYS(tree, left)) {
+			_btree_borrow_left(tree, parent, i, left, node);
+			break;
+		}
+
+		if(right && right->count > MIN_KEYS(tree, right)) {
+			_btree_borrow_right(tree, parent, i, node, right);
+			break;
+		}
+
+		if(left)
+			_btree_merge(tree, parent, i - 1, left, node);
+		else
+			_btree_merge(tree, parent, i, node, right);
+
+		node = parent;
+	}
+
+	btree_node_t* root = tree->root;
+	if(!root->leaf && root->count == 0) {
+		tree->root = CHILDREN(root)[0];
+		tree->height--;
+		free(root);
+	} else if(root->leaf && root->count == 0) {
+		tree->root = NULL;
+		tree->height = 0;
+		free(root);
+	}
+}
@@ -0,0 +1,269 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+A d-ary heap implementation in C with cache line aligned children
+*/
+
+#include "../include/dary_heap.h"
+
+#define DHEAP_MAX_ARITY 64
+
+#define AT(heap, i) ((heap)->data + (i) * (heap)->data_size)
+#define SCRATCH(heap) ((heap)->buffer)
+
+// children of i are (i << arity_log) + 1 ... (i << arity_log) + arity, at buffer slots
+// (i + 1) * arity onwards since data starts arity - 1 slots into the buffer
+
+
+// aligned buffer for capacity elements and the padding in front of them
+static char* _dheap_alloc(size_t capacity, size_t data_size, unsigned int arity) {
+	size_t bytes = (capacity + arity - 1) * data_size;
+	bytes = (bytes + DHEAP_CACHE_LINE - 1) / DHEAP_CACHE_LINE * DHEAP_CACHE_LINE;
+
+	return aligned_alloc(DHEAP_CACHE_LINE, bytes);
+}
+
+// aligned_alloc has no realloc, so the elements move to a new buffer
+static clib_exit_code_t _dheap_grow(dheap_t* heap, size_t capacity) {
+	char* buffer = _dheap_alloc(capacity, heap->data_size, heap->arity);
+	if(buffer == NULL)
+		return OUT_OF_MEM;
+
+	char* data = buffer + (heap->arity - 1) * heap->data_size;
+	memcpy(data, heap->data, heap->count * heap->data_size);
+
+	free(heap->buffer);
+	heap->buffer = buffer;
+	heap->data = data;
+	heap->capacity = capacity;
+
+	return OK;
+}
+
+// places elem, which must not live in the heap, at the hole it and moves it up
+static void _dheap_sift_up(dheap_t* heap, size_t it, const void* elem) {
+	while(it != 0) {
+		size_t parent = (it - 1) >> heap->arity_log;
+		if(!heap->compare(AT(heap, parent), elem))
+			break;
+
+		memcpy(AT(heap, it), AT(heap, parent), heap->data_size);
+		it = parent;
+	}
+
+	memcpy(AT(heap, it), elem, heap->data_size);
+}
+
+// places elem, which must not live in the heap, at the hole it and moves it down
+static void _dheap_sift_down(dheap_t* heap, size_t it, const void* elem) {
+	size_t first;
+
+	while((first = (it << heap->arity_log) + 1) < heap->count) {
+		size_t last = _min(first + heap->arity, heap->count);
+		size_t best = first;
+
+		for(size_t child = first + 1; child < last; child++)
+			if(heap->compare(AT(heap, best), AT(heap, child)))
+				best = child;
+
+		if(!heap->compare(elem, AT(heap, best)))
+			break;
+
+		memcpy(AT(heap, it), AT(heap, best), heap->data_size);
+		it = best;
+	}
+
+	memcpy(AT(heap, it), elem, heap->data_size);
+}
+
+dheap_t* dheap_init(size_t capacity, size_t data_size, unsigned int arity, uint8_t (*compare)(const void*, const void*)) {
+	if(data_size == 0 || compare == NULL)
+		return NULL;
+
+	dheap_t* heap = malloc(sizeof(*heap));
+	if(heap == NULL) {
+		printf("\n[dheap->dheap_init]: Not enough memory to create heap!\n");
+		return NULL;
+	}
+
+	heap->arity = 2;
+	heap->arity_log = 1;
+	while(heap->arity < arity && heap->arity < DHEAP_MAX_ARITY) {
+		heap->arity *= 2;
+		heap->arity_log++;
+	}
+
+	heap->capacity = _max(capacity, 1);
+	heap->count = 0;
+	heap->data_size = data_size;
+	heap->compare = compare;
+
+	heap->buffer = _dheap_alloc(heap->capacity, data_size, heap->arity);
+	if(heap->buffer == NULL) {
+		printf("\n[dheap->dheap_init]: Not enough memory to create heap!\n");
+		free(heap);
+		return NULL;
+	}
+	heap->data = heap->buffer + (heap->arity - 1) * data_size;
+
+	return heap;
+}
+
+dheap_t* dheap_from_array(const void* array, size_t count, size_t data_size, unsigned int arity,
+		uint8_t (*compare)(const void*, const void*)) {
+	if(array == NULL && count > 0) {
+		printf("\n[dheap->dheap_from_array]: Null reference to array! Returning NULL.\n");
+		return NULL;
+	}
+
+	dheap_t* heap = dheap_init(count, data_size, arity, compare);
+	if(heap == NULL)
+		return NULL;
+
+	if(count > 0)
+		memcpy(heap->data, array, count * data_size);
+	heap->count = count;
+
+	// bottom up from the last parent
+	if(count > 1) {
+		for(size_t i = ((count - 2) >> heap->arity_log) + 1; i-- > 0;) {
+			memcpy(SCRATCH(heap), AT(heap, i), data_size);
+			_dheap_sift_down(heap, i, SCRATCH(heap));
+		}
+	}
+
+	return heap;
+}
+
+clib_exit_code_t dheap_delete(dheap_t* heap) {
+	if(heap == NULL) {
+		printf("\n[dheap->dheap_delete]: Null reference to heap!\n");
+		return NULL_REF;
+	}
+
+	free(heap->buffer);
+	free(heap);
+
+	return OK;
+}
+
+clib_exit_code_t dheap_clear(dheap_t* heap) {
+	if(heap == NULL) {
+		printf("\n[dheap->dheap_clear]: Null reference to heap!\n");
+		return NULL_REF;
+	}
+
+	heap->count = 0;
+
+	return OK;
+}
+
+clib_exit_code_t dheap_swap(dheap_t* heap_a, dheap_t* heap_b) {
+	if(heap_a == NULL || heap_b == NULL) {
+		printf("\n[dheap->dheap_swap]: Null reference to heap!\n");
+		return NULL_REF;
+	}
+
+	dheap_t tmp = *heap_a;
+	*heap_a = *heap_b;
+	*heap_b = tmp;
+
+	return OK;
+}
+
+dheap_t* dheap_copy(dheap_t* heap) {
+	if(heap == NULL) {
+		printf("\n[dheap->dheap_copy]: Null reference to heap! Returning NULL.\n");
+		return NULL;
+	}
+
+	dheap_t* copy = dheap_init(heap->capacity, heap->data_size, heap->arity, heap->compare);
+	if(copy == NULL)
+		return NULL;
+
+	memcpy(copy->data, heap->data, heap->count * heap->data_size);
+	copy->count = heap->count;
+
+	return copy;
+}
+
+size_t dheap_count(dheap_t* heap) {
+	if(heap == NULL)
+		return 0;
+
+	return heap->count;
+}
+
+clib_exit_code_t dheap_insert(dheap_t* heap, const void* data) {
+	if(heap == NULL || data == NULL) {
+		printf("\n[dheap->dheap_insert]: Null reference to heap or data.\n");
+		return NULL_REF;
+	}
+
+	if(heap->count == heap->capacity) {
+		if(_dheap_grow(heap, 2 * heap->capacity) != OK) {
+			printf("\n[dheap->dheap_insert]: Not enough memory to grow the heap!\n");
+			return OUT_OF_MEM;
+		}
+	}
+
+	_dheap_sift_up(heap, heap->count++, data);
+
+	return OK;
+}
+
+clib_exit_code_t dheap_pop(dheap_t* heap) {
+	if(heap == NULL) {
+		printf("\n[dheap->dheap_pop]: Null reference to heap!\n");
+		return NULL_REF;
+	}
+
+	if(heap->count <= 1) {
+		heap->count = 0;
+		return OK;
+	}
+
+	heap->count--;
+	_dheap_sift_down(heap, 0, AT(heap, heap->count));
+
+	return OK;
+}
+
+clib_exit_code_t dheap_push_pop(dheap_t* heap, const void* data, void* out) {
+	if(heap == NULL || data == NULL || out == NULL) {
+		printf("\n[dheap->dheap_push_pop]: Null reference to heap, data or out!\n");
+		return NULL_REF;
+	}
+
+	if(heap->count == 0 || !heap->compare(data, heap->data)) {
+		memmove(out, data, heap->data_size);
+		return OK;
+	}
+
+	memcpy(SCRATCH(heap), heap->data, heap->data_size);
+	_dheap_sift_down(heap, 0, data);
+	memcpy(out, SCRATCH(heap), heap->data_size);
+
+	return OK;
+}
+
+clib_exit_code_t dheap_replace_top(dheap_t* heap, const void* data) {
+	if(heap == NULL || data == NULL) {
+		printf("\n[dheap->dheap_replace_top]: Null reference to heap or data!\n");
+		return NULL_REF;
+	}
+
+	if(heap->count == 0)
+		return OUT_OF_BOUNDS;
+
+	memcpy(SCRATCH(heap), data, heap->data_size);
+	_dheap_sift_down(heap, 0, SCRATCH(heap));
+
+	return OK;
+}
+
+const void* dheap_get_top(dheap_t* heap) {
+	if(heap == NULL || heap->count == 0)
+		return NULL;
+
+	return heap->data;
+}
@@ -0,0 +1,290 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+A sorted flat map implementation in C
+*/
+
+#include "../include/flat_map.h"
+
+#define KEY_AT(map, i) ((char*)(map)->keys + (size_t)(i) * (map)->key_size)
+#define DATA_AT(map, i) ((char*)(map)->data + (size_t)(i) * (map)->data_size)
+
+
+clib_exit_code_t _flat_map_reserve(flat_map_t* map, size_t capacity) {
+	if(capacity <= map->capacity)
+		return OK;
+
+	capacity = _max(capacity, 2 * map->capacity);
+
+	void* keys = realloc(map->keys, capacity * map->key_size);
+	if(keys == NULL)
+		return OUT_OF_MEM;
+	map->keys = keys;
+
+	void* data = realloc(map->data, capacity * map->data_size);
+	if(data == NULL)
+		return OUT_OF_MEM;
+	map->data = data;
+
+	map->capacity = capacity;
+
+	return OK;
+}
+
+// index of the first key not smaller than key
+// the loop halves the range unconditionally and only selects the next base,
+// which compiles to a conditional move instead of an unpredictable branch
+size_t _flat_map_lower_index(flat_map_t* map, const void* key) {
+	size_t base = 0;
+	size_t n = map->count;
+
+	if(n == 0)
+		return 0;
+
+	while(n > 1) {
+		size_t half = n / 2;
+		// both possible next probes, so the load overlaps the comparison
+		__builtin_prefetch(KEY_AT(map, base + half / 2));
+		__builtin_prefetch(KEY_AT(map, base + half + half / 2));
+		base = map->comparation(KEY_AT(map, base + half - 1), key) < 0 ? base + half : base;
+		n -= half;
+	}
+
+	return base + (map->comparation(KEY_AT(map, base), key) < 0);
+}
+
+flat_map_t* flat_map_init(unsigned int data_size, unsigned int key_size, int (*comparation)(const void*, const void*)) {
+	flat_map_t* map = malloc(sizeof(*map));
+	if(map == NULL) {
+		printf("\n[flat_map->flat_map_init]: Not enough memory to create flat map!");
+		printf(" Returned NULL\n");
+		return NULL;
+	}
+
+	map->keys = NULL;
+	map->data = NULL;
+	map->count = 0;
+	map->capacity = 0;
+	map->data_size = data_size;
+	map->key_size = key_size;
+	map->comparation = comparation;
+
+	return map;
+}
+
+void flat_map_delete(flat_map_t* map) {
+	if(map) {
+		free(map->keys);
+		free(map->data);
+		free(map);
+	}
+}
+
+size_t flat_map_count(flat_map_t* map) {
+	if(map)
+		return map->count;
+	return 0;
+}
+
+// stable bottom-up merge sort of positions by key, tmp is scratch of the same size
+static void _flat_map_sort_index(flat_map_t* map, const void* keys, size_t* index, size_t* tmp, size_t count) {
+	size_t* src = index;
+	size_t* dst = tmp;
+
+	for(size_t width = 1; width < count; width *= 2) {
+		for(size_t left = 0; left < count; left += 2 * width) {
+			size_t mid = _min(left + width, count);
+			size_t right = _min(left + 2 * width, count);
+			size_t i = left, j = mid, k = left;
+
+			while(i < mid && j < right) {
+				const void* a = (const char*)keys + src[i] * map->key_size;
+				const void* b = (const char*)keys + src[j] * map->key_size;
+				dst[k++] = map->comparation(b, a) < 0 ? src[j++] : src[i++];
+			}
+			while(i < mid)
+				dst[k++] = src[i++];
+			while(j < right)
+				dst[k++] = src[j++];
+		}
+
+		size_t* swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	if(src != index)
+		memcpy(index, src, count * sizeof(size_t));
+}
+
+clib_exit_code_t flat_map_build(flat_map_t* map, const void* keys, const void* data, size_t count) {
+	if(map == NULL || (count > 0 && (keys == NULL || data == NULL))) {
+		printf("\n[flat_map->flat_map_build]: Null reference to flat map!\n");
+		return NULL_REF;
+	}
+
+	map->count = 0;
+	if(count == 0)
+		return OK;
+	if(_flat_map_reserve(map, count) != OK)
+		return OUT_OF_MEM;
+
+	// already strictly ascending input is copied as is
+	size_t sorted = 1;
+	for(size_t i = 1; i < count && sorted; i++)
+		sorted = map->comparation((const char*)keys + (i - 1) * map->key_size, (const char*)keys + i * map->key_size) < 0;
+
+	if(sorted) {
+		memcpy(map->keys, keys, count * map->key_size);
+		memcpy(map->data, data, count * map->data_size);
+		map->count = count;
+		return OK;
+	}
+
+	size_t* index = malloc(2 * count * sizeof(size_t));
+	if(index == NULL)
+		return OUT_OF_MEM;
+
+	for(size_t i = 0; i < count; i++)
+		index[i] = i;
+	_flat_map_sort_index(map, keys, index, index + count, count);
+
+	// equal keys are adjacent and in input order, keep the last one of each run
+	for(size_t i = 0; i < count; i++) {
+		const void* key = (const char*)keys + index[i] * map->key_size;
+		const void* value = (const char*)data + index[i] * map->data_size;
+
+		if(map->count > 0 && map->comparation(KEY_AT(map, map->count - 1), key) == 0) {
+			memcpy(DATA_AT(map, map->count - 1), value, map->data_size);
+			continue;
+		}
+
+		memcpy(KEY_AT(map, map->count), key, map->key_size);
+		memcpy(DATA_AT(map, map->count), value, map->data_size);
+		map->count++;
+	}
+
+	free(index);
+
+	return OK;
+}
+
+clib_exit_code_t flat_map_insert(flat_map_t* map, void* key, void* data) {
+	if(map == NULL || key == NULL || data == NULL) {
+		printf("\n[flat_map->flat_map_insert]: Null reference to flat map!\n");
+		return NULL_REF;
+	}
+
+	size_t pos = _flat_map_lower_index(map, key);
+	if(pos < map->count && map->comparation(KEY_AT(map, pos), key) == 0) {
+		memcpy(DATA_AT(map, pos), data, map->data_size);
+		return OK;
+	}
+
+	if(_flat_map_reserve(map, map->count + 1) != OK)
+		return OUT_OF_MEM;
+
+	size_t tail = map->count - pos;
+	memmove(KEY_AT(map, pos + 1), KEY_AT(map, pos), tail * map->key_size);
+	memmove(DATA_AT(map, pos + 1), DATA_AT(map, pos), tail * map->data_size);
+	memcpy(KEY_AT(map, pos), key, map->key_size);
+	memcpy(DATA_AT(map, pos), data, map->data_size);
+	map->count++;
+
+	return OK;
+}
+
+void flat_map_erase(flat_map_t* map, void* key) {
+	if(map == NULL || key == NULL)
+		return;
+
+	size_t pos = _flat_map_lower_index(map, key);
+	if(pos == map->count || map->comparation(KEY_AT(map, pos), key) != 0)
+		return;
+
+	size_t tail = map->count - pos - 1;
+	memmove(KEY_AT(map, pos), KEY_AT(map, pos + 1), tail * map->key_size);
+	memmove(DATA_AT(map, pos), DATA_AT(map, pos + 1), tail * map->data_size);
+	map->count--;
+}
+
+const void* flat_map_search(flat_map_t* map, void* key) {
+	if(map == NULL || key == NULL)
+		return NULL;
+
+	size_t pos = _flat_map_lower_index(map, key);
+	if(pos == map->count || map->comparation(KEY_AT(map, pos), key) != 0)
+		return NULL;
+
+	return DATA_AT(map, pos);
+}
+
+const void* flat_map_lower_bound(flat_map_t* map, void* key) {
+	if(map == NULL || key == NULL)
+		return NULL;
+
+	size_t pos = _flat_map_lower_index(map, key);
+	if(pos == map->count)
+		return NULL;
+
+	return KEY_AT(map, pos);
+}
+
+const void* flat_map_min_key(flat_map_t* map) {
+	if(map == NULL || map->count == 0)
+		return NULL;
+	return KEY_AT(map, 0);
+}
+
+const void* flat_map_max_key(flat_map_t* map) {
+	if(map == NULL || map->count == 0)
+		return NULL;
+	return KEY_AT(map, map->count - 1);
+}
+
+const void* flat_map_key_at(flat_map_t* map, size_t index) {
+	if(map == NULL || index >= map->count)
+		return NULL;
+	return KEY_AT(map, index);
+}
+
+const void* flat_map_data_at(flat_map_t* map, size_t index) {
+	if(map == NULL || index >= map->count)
+		return NULL;
+	return DATA_AT(map, index);
+}
+
+flat_map_t* flat_map_copy(flat_map_t* map) {
+	if(map == NULL)
+		return NULL;
+
+	flat_map_t* copy = flat_map_init(map->data_size, map->key_size, map->comparation);
+	if(copy == NULL)
+		return NULL;
+
+	if(_flat_map_reserve(copy, map->count) != OK) {
+		flat_map_delete(copy);
+		return NULL;
+	}
+
+	if(map->count > 0) {
+		memcpy(copy->keys, map->keys, map->count * map->key_size);
+		memcpy(copy->data, map->data, map->count * map->data_size);
+	}
+	copy->count = map->count;
+
+	return copy;
+}
+
+void flat_map_clear(flat_map_t* map) {
+	if(map)
+		map->count = 0;
+}
+
+void flat_map_swap(flat_map_t* a, flat_map_t* b) {
+	if(a == NULL || b == NULL)
+		return;
+
+	flat_map_t tmp = *a;
+	*a = *b;
+	*b = tmp;
+}
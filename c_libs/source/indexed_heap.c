@@ -0,0 +1,284 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+An addressable heap implementation in C, elements are reached through handles
+*/
+
+#include "../include/indexed_heap.h"
+
+#define IHEAP_ARITY 4
+
+#define DATA(heap, handle) ((heap)->data + (handle) * (heap)->data_size)
+
+// only handles move inside the heap, the elements never do
+
+
+static clib_exit_code_t _iheap_grow(iheap_t* heap, size_t capacity) {
+	iheap_handle_t* order = realloc(heap->heap, capacity * sizeof(iheap_handle_t));
+	if(order == NULL)
+		return OUT_OF_MEM;
+	heap->heap = order;
+
+	size_t* position = realloc(heap->position, capacity * sizeof(size_t));
+	if(position == NULL)
+		return OUT_OF_MEM;
+	heap->position = position;
+
+	iheap_handle_t* free_handles = realloc(heap->free_handles, capacity * sizeof(iheap_handle_t));
+	if(free_handles == NULL)
+		return OUT_OF_MEM;
+	heap->free_handles = free_handles;
+
+	char* data = realloc(heap->data, capacity * heap->data_size);
+	if(data == NULL)
+		return OUT_OF_MEM;
+	heap->data = data;
+
+	heap->capacity = capacity;
+
+	return OK;
+}
+
+// places handle at the hole pos and moves it up
+static void _iheap_sift_up(iheap_t* heap, size_t pos, iheap_handle_t handle) {
+	const void* elem = DATA(heap, handle);
+
+	while(pos != 0) {
+		size_t parent = (pos - 1) / IHEAP_ARITY;
+		iheap_handle_t above = heap->heap[parent];
+		if(!heap->compare(DATA(heap, above), elem))
+			break;
+
+		heap->heap[pos] = above;
+		heap->position[above] = pos;
+		pos = parent;
+	}
+
+	heap->heap[pos] = handle;
+	heap->position[handle] = pos;
+}
+
+// places handle at the hole pos and moves it down
+static void _iheap_sift_down(iheap_t* heap, size_t pos, iheap_handle_t handle) {
+	const void* elem = DATA(heap, handle);
+	size_t first;
+
+	while((first = pos * IHEAP_ARITY + 1) < heap->count) {
+		size_t last = _min(first + IHEAP_ARITY, heap->count);
+		size_t best = first;
+
+		for(size_t child = first + 1; child < last; child++)
+			if(heap->compare(DATA(heap, heap->heap[best]), DATA(heap, heap->heap[child])))
+				best = child;
+
+		iheap_handle_t below = heap->heap[best];
+		if(!heap->compare(elem, DATA(heap, below)))
+			break;
+
+		heap->heap[pos] = below;
+		heap->position[below] = pos;
+		pos = best;
+	}
+
+	heap->heap[pos] = handle;
+	heap->position[handle] = pos;
+}
+
+// takes the handle at pos out, the last handle fills its place
+static void _iheap_remove_at(iheap_t* heap, size_t pos) {
+	iheap_handle_t removed = heap->heap[pos];
+	heap->position[removed] = IHEAP_NONE;
+	heap->free_handles[heap->free_count++] = removed;
+
+	iheap_handle_t last = heap->heap[--heap->count];
+	if(pos == heap->count)
+		return;
+
+	if(pos != 0 && heap->compare(DATA(heap, heap->heap[(pos - 1) / IHEAP_ARITY]), DATA(heap, last)))
+		_iheap_sift_up(heap, pos, last);
+	else
+		_iheap_sift_down(heap, pos, last);
+}
+
+iheap_t* iheap_init(size_t capacity, size_t data_size, uint8_t (*compare)(const void*, const void*)) {
+	if(data_size == 0 || compare == NULL)
+		return NULL;
+
+	iheap_t* heap = calloc(1, sizeof(*heap));
+	if(heap == NULL) {
+		printf("\n[iheap->iheap_init]: Not enough memory to create heap!\n");
+		return NULL;
+	}
+
+	heap->data_size = data_size;
+	heap->compare = compare;
+
+	if(_iheap_grow(heap, _max(capacity, 1)) != OK) {
+		printf("\n[iheap->iheap_init]: Not enough memory to create heap!\n");
+		iheap_delete(heap);
+		return NULL;
+	}
+
+	return heap;
+}
+
+clib_exit_code_t iheap_delete(iheap_t* heap) {
+	if(heap == NULL) {
+		printf("\n[iheap->iheap_delete]: Null reference to heap!\n");
+		return NULL_REF;
+	}
+
+	free(heap->heap);
+	free(heap->position);
+	free(heap->free_handles);
+	free(heap->data);
+	free(heap);
+
+	return OK;
+}
+
+clib_exit_code_t iheap_clear(iheap_t* heap) {
+	if(heap == NULL) {
+		printf("\n[iheap->iheap_clear]: Null reference to heap!\n");
+		return NULL_REF;
+	}
+
+	heap->count = 0;
+	heap->used = 0;
+	heap->free_count = 0;
+
+	return OK;
+}
+
+size_t iheap_count(iheap_t* heap) {
+	if(heap == NULL)
+		return 0;
+
+	return heap->count;
+}
+
+clib_exit_code_t iheap_push(iheap_t* heap, const void* data, iheap_handle_t* handle) {
+	if(heap == NULL || data == NULL) {
+		printf("\n[iheap->iheap_push]: Null reference to heap or data!\n");
+		return NULL_REF;
+	}
+
+	if(heap->free_count == 0 && heap->used == heap->capacity) {
+		if(_iheap_grow(heap, 2 * heap->capacity) != OK) {
+			printf("\n[iheap->iheap_push]: Not enough memory to grow the heap!\n");
+			return OUT_OF_MEM;
+		}
+	}
+
+	iheap_handle_t added = heap->free_count ? heap->free_handles[--heap->free_count] : heap->used++;
+	memcpy(DATA(heap, added), data, heap->data_size);
+
+	_iheap_sift_up(heap, heap->count++, added);
+
+	if(handle)
+		*handle = added;
+
+	return OK;
+}
+
+clib_exit_code_t iheap_pop(iheap_t* heap) {
+	if(heap == NULL) {
+		printf("\n[iheap->iheap_pop]: Null reference to heap!\n");
+		return NULL_REF;
+	}
+
+	if(heap->count == 0)
+		return OK;
+
+	_iheap_remove_at(heap, 0);
+
+	return OK;
+}
+
+const void* iheap_get_top(iheap_t* heap) {
+	if(heap == NULL || heap->count == 0)
+		return NULL;
+
+	return DATA(heap, heap->heap[0]);
+}
+
+iheap_handle_t iheap_top_handle(iheap_t* heap) {
+	if(heap == NULL || heap->count == 0)
+		return IHEAP_NONE;
+
+	return heap->heap[0];
+}
+
+int iheap_contains(iheap_t* heap, iheap_handle_t handle) {
+	return heap && handle < heap->used && heap->position[handle] != IHEAP_NONE;
+}
+
+const void* iheap_get(iheap_t* heap, iheap_handle_t handle) {
+	if(!iheap_contains(heap, handle))
+		return NULL;
+
+	return DATA(heap, handle);
+}
+
+clib_exit_code_t iheap_update(iheap_t* heap, iheap_handle_t handle, const void* data) {
+	if(heap == NULL || data == NULL)
+		return NULL_REF;
+
+	if(!iheap_contains(heap, handle))
+		return OUT_OF_BOUNDS;
+
+	// comes before the old element means up, otherwise down
+	int up = heap->compare(DATA(heap, handle), data);
+
+	memmove(DATA(heap, handle), data, heap->data_size);
+
+	if(up)
+		_iheap_sift_up(heap, heap->position[handle], handle);
+	else
+		_iheap_sift_down(heap, heap->position[handle], handle);
+
+	return OK;
+}
+
+clib_exit_code_t iheap_decrease_key(iheap_t* heap, iheap_handle_t handle, const void* data) {
+	if(heap == NULL || data == NULL)
+		return NULL_REF;
+
+	if(!iheap_contains(heap, handle))
+		return OUT_OF_BOUNDS;
+
+	if(heap->compare(data, DATA(heap, handle)))
+		return UNSAFE;
+
+	memmove(DATA(heap, handle), data, heap->data_size);
+	_iheap_sift_up(heap, heap->position[handle], handle);
+
+	return OK;
+}
+
+clib_exit_code_t iheap_increase_key(iheap_t* heap, iheap_handle_t handle, const void* data) {
+	if(heap == NULL || data == NULL)
+		return NULL_REF;
+
+	if(!iheap_contains(heap, handle))
+		return OUT_OF_BOUNDS;
+
+	if(heap->compare(DATA(heap, handle), data))
+		return UNSAFE;
+
+	memmove(DATA(heap, handle), data, heap->data_size);
+	_iheap_sift_down(heap, heap->position[handle], handle);
+
+	return OK;
+}
+
+clib_exit_code_t iheap_erase(iheap_t* heap, iheap_handle_t handle) {
+	if(heap == NULL)
+		return NULL_REF;
+
+	if(!iheap_contains(heap, handle))
+		return OUT_OF_BOUNDS;
+
+	_iheap_remove_at(heap, heap->position[handle]);
+
+	return OK;
+}
@@ -0,0 +1,463 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+A persistent AVL tree in C, copies share their nodes
+*/
+
+#include "../include/pavl.h"
+
+#include <stddef.h>
+
+#define PAVL_MAX_ALIGN 16
+
+#define NODE_KEY(tree, node) ((void*)((char*)(node) + (tree)->key_offset))
+#define NODE_DATA(tree, node) ((void*)((char*)(node) + (tree)->data_offset))
+
+// a node with a single reference is reachable only through the tree being
+// changed, every node another copy can reach has more references or hangs
+// under one that does, so updates copy the shared nodes on their path and
+// change the rest in place, different copies can be used from different threads
+
+
+// alignment a field of this size needs, the largest power of two dividing it
+static size_t _pavl_align_of(size_t size) {
+	size_t align = 1;
+	while(align < PAVL_MAX_ALIGN && size % (2 * align) == 0)
+		align *= 2;
+	return align;
+}
+
+static size_t _pavl_align_up(size_t offset, size_t align) {
+	return (offset + align - 1) / align * align;
+}
+
+pavl_tree_t* pavl_tree_init(unsigned int data_size, unsigned int key_size, int (*comparation)(const void*, const void*)) {
+	pavl_tree_t* tree = malloc(sizeof(pavl_tree_t));
+	if(tree == NULL)
+		return NULL;
+
+	tree->count = 0;
+	tree->root = NULL;
+	tree->data_size = data_size;
+	tree->key_size = key_size;
+	tree->comparation = comparation;
+
+	size_t key_align = _pavl_align_of(key_size);
+	size_t data_align = _pavl_align_of(data_size);
+	size_t node_align = _max(_Alignof(pavl_node_t), _max(key_align, data_align));
+
+	tree->key_offset = _pavl_align_up(offsetof(pavl_node_t, payload), key_align);
+	tree->data_offset = _pavl_align_up(tree->key_offset + key_size, data_align);
+	tree->node_size = _pavl_align_up(tree->data_offset + data_size, node_align);
+
+	return tree;
+}
+
+int pavl_tree_count(const pavl_tree_t* tree) {
+	if(tree)
+		return tree->count;
+	return 0;
+}
+
+// NODES
+
+static pavl_node_t* _pavl_node_retain(pavl_node_t* node) {
+	if(node)
+		atomic_fetch_add_explicit(&node->refs, 1, memory_order_relaxed);
+	return node;
+}
+
+// drops one reference, the node and whatever only it kept alive are freed with the last one
+static void _pavl_node_release(pavl_node_t* node) {
+	while(node && atomic_fetch_sub_explicit(&node->refs, 1, memory_order_acq_rel) == 1) {
+		pavl_node_t* right = node->right;
+
+		_pavl_node_release(node->left);
+		free(node);
+
+		node = right;
+	}
+}
+
+static pavl_node_t* _pavl_node_new(pavl_tree_t* tree, const void* key, const void* data) {
+	pavl_node_t* node = malloc(tree->node_size);
+	if(node == NULL)
+		return NULL;
+
+	memcpy(NODE_KEY(tree, node), key, tree->key_size);
+	memcpy(NODE_DATA(tree, node), data, tree->data_size);
+	node->left = NULL;
+	node->right = NULL;
+	node->height = 1;
+	atomic_init(&node->refs, 1);
+
+	return node;
+}
+
+// the node at link made private to this tree, copied when shared,
+// NULL when the copy can not be allocated and link is left untouched
+static pavl_node_t* _pavl_node_own(pavl_tree_t* tree, pavl_node_t** link) {
+	pavl_node_t* node = *link;
+	if(atomic_load_explicit(&node->refs, memory_order_acquire) == 1)
+		return node;
+
+	pavl_node_t* copy = malloc(tree->node_size);
+	if(copy == NULL)
+		return NULL;
+
+	// other threads may be changing refs, so it is not part of the copied bytes
+	size_t header = offsetof(pavl_node_t, payload);
+	memcpy((char*)copy + header, (char*)node + header, tree->node_size - header);
+	copy->left = node->left;
+	copy->right = node->right;
+	copy->height = node->height;
+	atomic_init(&copy->refs, 1);
+	_pavl_node_retain(copy->left);
+	_pavl_node_retain(copy->right);
+
+	*link = copy;
+	_pavl_node_release(node);
+
+	return copy;
+}
+
+static int _pavl_node_height(pavl_node_t* node) {
+	if(node == NULL)
+		return 0;
+
+	return node->height;
+}
+
+static void _pavl_node_update_height(pavl_node_t* node) {
+	int left = _pavl_node_height(node->left);
+	int right = _pavl_node_height(node->right);
+
+	node->height = (left > right ? left : right) + 1;
+}
+
+static int _pavl_node_balance_factor(pavl_node_t* node) {
+	if(node == NULL)
+		return 0;
+
+	return _pavl_node_height(node->left) - _pavl_node_height(node->right);
+}
+
+// node must be owned, the child rising above it is owned first,
+// without memory for that the rotation is skipped and the tree stays valid, only less balanced
+static pavl_node_t* _pavl_node_rotate_left(pavl_tree_t* tree, pavl_node_t* node) {
+	pavl_node_t* y = _pavl_node_own(tree, &node->right);
+	if(y == NULL)
+		return node;
+
+	node->right = y->left;
+	y->left = node;
+
+	_pavl_node_update_height(node);
+	_pavl_node_update_height(y);
+
+	return y;
+}
+
+static pavl_node_t* _pavl_node_rotate_right(pavl_tree_t* tree, pavl_node_t* node) {
+	pavl_node_t* x = _pavl_node_own(tree, &node->left);
+	if(x == NULL)
+		return node;
+
+	node->left = x->right;
+	x->right = node;
+
+	_pavl_node_update_height(node);
+	_pavl_node_update_height(x);
+
+	return x;
+}
+
+// restores balance at an owned node after one of its subtrees changed height by one
+static pavl_node_t* _pavl_node_rebalance(pavl_tree_t* tree, pavl_node_t* node) {
+	_pavl_node_update_height(node);
+
+	int balance_factor = _pavl_node_balance_factor(node);
+
+	if(balance_factor > 1) {
+		if(_pavl_node_balance_factor(node->left) < 0) {
+			pavl_node_t* left = _pavl_node_own(tree, &node->left);
+			if(left)
+				node->left = _pavl_node_rotate_left(tree, left);
+		}
+		return _pavl_node_rotate_right(tree, node);
+	}
+
+	if(balance_factor < -1) {
+		if(_pavl_node_balance_factor(node->right) > 0) {
+			pavl_node_t* right = _pavl_node_own(tree, &node->right);
+			if(right)
+				node->right = _pavl_node_rotate_right(tree, right);
+		}
+		return _pavl_node_rotate_left(tree, node);
+	}
+
+	return node;
+}
+
+// path holds the links from the root down to the changed subtree, all to owned nodes
+static void _pavl_rebalance_path(pavl_tree_t* tree, pavl_node_t** path[], int depth) {
+	while(depth-- > 0) {
+		pavl_node_t** link = path[depth];
+		int height = (*link)->height;
+
+		*link = _pavl_node_rebalance(tree, *link);
+
+		if((*link)->height == height)
+			return;
+	}
+}
+
+static pavl_node_t* _pavl_node_find(const pavl_tree_t* tree, const void* key) {
+	pavl_node_t* node = tree->root;
+
+	while(node) {
+		int diff = tree->comparation(key, NODE_KEY(tree, node));
+		if(diff == 0)
+			return node;
+
+		node = diff < 0 ? node->left : node->right;
+	}
+
+	return NULL;
+}
+
+// TREES
+
+void pavl_tree_delete(pavl_tree_t* tree) {
+	if(tree) {
+		_pavl_node_release(tree->root);
+		free(tree);
+	}
+}
+
+pavl_tree_t* pavl_tree_copy(pavl_tree_t* tree) {
+	if(tree == NULL)
+		return NULL;
+
+	pavl_tree_t* copy = malloc(sizeof(pavl_tree_t));
+	if(copy == NULL)
+		return NULL;
+
+	*copy = *tree;
+	_pavl_node_retain(copy->root);
+
+	return copy;
+}
+
+clib_exit_code_t pavl_tree_insert(pavl_tree_t* tree, const void* key, const void* data) {
+	if(tree == NULL || key == NULL || data == NULL)
+		return NULL_REF;
+
+	pavl_node_t** path[PAVL_MAX_HEIGHT];
+	int depth = 0;
+	pavl_node_t** link = &tree->root;
+
+	while(*link) {
+		pavl_node_t* node = _pavl_node_own(tree, link);
+		if(node == NULL)
+			return OUT_OF_MEM;
+
+		int diff = tree->comparation(key, NODE_KEY(tree, node));
+		if(diff == 0) {
+			memcpy(NODE_DATA(tree, node), data, tree->data_size);
+			return OK;
+		}
+
+		path[depth++] = link;
+		link = diff < 0 ? &node->left : &node->right;
+	}
+
+	*link = _pavl_node_new(tree, key, data);
+	if(*link == NULL)
+		return OUT_OF_MEM;
+
+	tree->count++;
+	_pavl_rebalance_path(tree, path, depth);
+
+	return OK;
+}
+
+clib_exit_code_t pavl_tree_erase(pavl_tree_t* tree, const void* key) {
+	if(tree == NULL || key == NULL)
+		return NULL_REF;
+
+	// a missing key must not copy the path
+	if(_pavl_node_find(tree, key) == NULL)
+		return OK;
+
+	pavl_node_t** path[PAVL_MAX_HEIGHT];
+	int depth = 0;
+	pavl_node_t** link = &tree->root;
+	pavl_node_t* node = NULL;
+
+	while(1) {
+		node = _pavl_node_own(tree, link);
+		if(node == NULL)
+			return OUT_OF_MEM;
+
+		int diff = tree->comparation(key, NODE_KEY(tree, node));
+		if(diff == 0)
+			break;
+
+		path[depth++] = link;
+		link = diff < 0 ? &node->left : &node->right;
+	}
+
+	if(node->left == NULL || node->right == NULL) {
+		*link = node->left ? node->left : node->right;
+	} else {
+		// the successor is unlinked and takes the place of node
+		int node_depth = depth;
+		path[depth++] = link;
+
+		pavl_node_t** next_link = &node->right;
+		pavl_node_t* next = NULL;
+
+		while(1) {
+			next = _pavl_node_own(tree, next_link);
+			if(next == NULL)
+				return OUT_OF_MEM;
+			if(next->left == NULL)
+				break;
+
+			path[depth++] = next_link;
+			next_link = &next->left;
+		}
+
+		*next_link = next->right;
+
+		next->left = node->left;
+		next->right = node->right;
+		next->height = node->height;
+		*link = next;
+
+		// the link below the moved node now lives in the successor
+		if(depth > node_depth + 1)
+			path[node_depth + 1] = &next->right;
+	}
+
+	// its children were handed over with their references
+	free(node);
+	tree->count--;
+	_pavl_rebalance_path(tree, path, depth);
+
+	return OK;
+}
+
+const void* pavl_tree_search(const pavl_tree_t* tree, const void* key) {
+	if(tree == NULL || key == NULL)
+		return NULL;
+
+	pavl_node_t* node = _pavl_node_find(tree, key);
+	if(node == NULL)
+		return NULL;
+
+	return NODE_DATA(tree, node);
+}
+
+const void* pavl_min_key(const pavl_tree_t* tree) {
+	if(tree == NULL || tree->root == NULL)
+		return NULL;
+
+	pavl_node_t* node = tree->root;
+	while(node->left)
+		node = node->left;
+
+	return NODE_KEY(tree, node);
+}
+
+const void* pavl_max_key(const pavl_tree_t* tree) {
+	if(tree == NULL || tree->root == NULL)
+		return NULL;
+
+	pavl_node_t* node = tree->root;
+	while(node->right)
+		node = node->right;
+
+	return NODE_KEY(tree, node);
+}
+
+const void* pavl_lower_bound(const pavl_tree_t* tree, const void* key) {
+	if(tree == NULL || key == NULL)
+		return NULL;
+
+	pavl_node_t* node = tree->root;
+	pavl_node_t* result = NULL;
+
+	while(node) {
+		int diff = tree->comparation(key, NODE_KEY(tree, node));
+		if(diff == 0)
+			return NODE_KEY(tree, node);
+
+		if(diff < 0) {
+			result = node;
+			node = node->left;
+		} else {
+			node = node->right;
+		}
+	}
+
+	if(result == NULL)
+		return NULL;
+
+	return NODE_KEY(tree, result);
+}
+
+void pavl_tree_clear(pavl_tree_t* tree) {
+	if(tree) {
+		_pavl_node_release(tree->root);
+		tree->root = NULL;
+		tree->count = 0;
+	}
+}
+
+void pavl_tree_swap(pavl_tree_t* a, pavl_tree_t* b) {
+	if(a == NULL || b == NULL)
+		return;
+
+	pavl_tree_t tmp = *a;
+	*a = *b;
+	*b = tmp;
+}
+
+size_t pavl_range_scan(const pavl_tree_t* tree, const void* lo, const void* hi,
+		int (*callback)(const void* key, const void* data, void* arg), void* arg) {
+	if(tree == NULL || callback == NULL)
+		return 0;
+
+	// nodes still to visit, each one above its left subtree
+	pavl_node_t* stack[PAVL_MAX_HEIGHT];
+	int depth = 0;
+
+	for(pavl_node_t* node = tree->root; node;) {
+		if(lo && tree->comparation(NODE_KEY(tree, node), lo) < 0) {
+			node = node->right;
+		} else {
+			stack[depth++] = node;
+			node = node->left;
+		}
+	}
+
+	size_t calls = 0;
+
+	while(depth > 0) {
+		pavl_node_t* node = stack[--depth];
+		const void* key = NODE_KEY(tree, node);
+
+		if(hi && tree->comparation(key, hi) > 0)
+			break;
+
+		calls++;
+		if(callback(key, NODE_DATA(tree, node), arg))
+			break;
+
+		for(node = node->right; node; node = node->left)
+			stack[depth++] = node;
+	}
+
+	return calls;
+}
@@ -1,16 +1,27 @@
 #include "../include/queue.h"
 
+#define QUEUE_MIN_CAPACITY 16
 
-clib_exit_code_t _queue_free_node(queue_node_t* node) {
-	if(node == NULL) {
-		return NULL_REF;
-	}
+#define QUEUE_AT(queue, i) ((char*)(queue)->data + ((i) & ((queue)->capacity - 1)) * (queue)->data_size)
 
-	if(node->data) {
-		free(node->data);
-	}
 
-	return OK;
+// copies count elements starting at ring position pos into out, handling the wrap
+void _queue_read(queue_t* queue, size_t pos, void* out, size_t count) {
+	size_t start = pos & (queue->capacity - 1);
+	size_t first = _min(count, queue->capacity - start);
+
+	memcpy(out, (char*)queue->data + start * queue->data_size, first * queue->data_size);
+	memcpy((char*)out + first * queue->data_size, queue->data, (count - first) * queue->data_size);
+}
+
+
+// copies count elements from in to the ring starting at position pos, handling the wrap
+void _queue_write(queue_t* queue, size_t pos, const void* in, size_t count) {
+	size_t start = pos & (queue->capacity - 1);
+	size_t first = _min(count, queue->capacity - start);
+
+	memcpy((char*)queue->data + start * queue->data_size, in, first * queue->data_size);
+	memcpy(queue->data, (const char*)in + first * queue->data_size, (count - first) * queue->data_size);
 }
 
 
@@ -24,10 +35,16 @@ queue_t* queue_init(size_t data_size) {
 		return NULL;
 	}
 
+	queue->data = malloc(QUEUE_MIN_CAPACITY * data_size);
+	if(queue->data == NULL) {
+		free(queue);
+		return NULL;
+	}
+
 	queue->data_size = data_size;
 	queue->count = 0;
-	queue->head = NULL;
-	queue->tail = NULL;
+	queue->capacity = QUEUE_MIN_CAPACITY;
+	queue->head = 0;
 
 	return queue;
 }
@@ -39,17 +56,7 @@ clib_exit_code_t queue_delete(queue_t* queue) {
 		return NULL_REF;
 	}
 
-	queue_node_t* node = queue->head;
-	queue_node_t* tmp = NULL;
-
-	while(node != NULL) {
-		tmp = node;
-		node = node->next;
-
-		_queue_free_node(tmp);
-		free(tmp);
-	}
-
+	free(queue->data);
 	free(queue);
 
 	return OK;
@@ -62,20 +69,40 @@ clib_exit_code_t queue_swap(queue_t* queue_1, queue_t* queue_2) {
 		return NULL_REF;
 	}
 
-	size_t data_size_1 = queue_1->data_size;
-	size_t count_1 = queue_1->count;
-	queue_node_t* head_1 = queue_1->head;
-	queue_node_t* tail_1 = queue_1->tail;
+	queue_t tmp = *queue_1;
+	*queue_1 = *queue_2;
+	*queue_2 = tmp;
+
+	return OK;
+}
+
+
+// make room for at least capacity elements without further reallocations
+clib_exit_code_t queue_reserve(queue_t* queue, size_t capacity) {
+	if(queue == NULL) {
+		return NULL_REF;
+	}
+
+	if(capacity <= queue->capacity) {
+		return OK;
+	}
+
+	size_t new_capacity = queue->capacity;
+	while(new_capacity < capacity)
+		new_capacity *= 2;
+
+	void* data = malloc(new_capacity * queue->data_size);
+	if(data == NULL) {
+		return OUT_OF_MEM;
+	}
 
-	queue_1->data_size = queue_2->data_size;
-	queue_1->count = queue_2->count;
-	queue_1->head = queue_2->head;
-	queue_1->tail = queue_2->tail;
+	// unwrap the elements to the start of the new buffer
+	_queue_read(queue, queue->head, data, queue->count);
+	free(queue->data);
 
-	queue_2->data_size = data_size_1;
-	queue_2->count = count_1;
-	queue_2->head = head_1;
-	queue_2->tail = tail_1;
+	queue->data = data;
+	queue->capacity = new_capacity;
+	queue->head = 0;
 
 	return OK;
 }
@@ -88,18 +115,18 @@ queue_t* queue_copy(queue_t* queue) {
 	}
 
 	queue_t* copy = queue_init(queue->data_size);
+	if(copy == NULL) {
+		return NULL;
+	}
 
-	queue_node_t* node = queue->head;
-
-	while (node != NULL) {
-		clib_exit_code_t err = queue_push(copy, node->data);
-		if (err) {
-			return copy;
-		}
-
-		node = node->next;
+	if(queue_reserve(copy, queue->count) != OK) {
+		queue_delete(copy);
+		return NULL;
 	}
 
+	_queue_read(queue, queue->head, copy->data, queue->count);
+	copy->count = queue->count;
+
 	return copy;
 }
 
@@ -110,18 +137,7 @@ clib_exit_code_t queue_clear(queue_t* queue) {
 		return NULL_REF;
 	}
 
-	queue_node_t* node = queue->head;
-	queue_node_t* tmp = NULL;
-
-	while(node != NULL) {
-		tmp = node;
-		node = node->next;
-
-		_queue_free_node(tmp);
-		free(tmp);
-	}
-
-	queue->head = queue->tail = NULL;
+	queue->head = 0;
 	queue->count = 0;
 
 	return OK;
@@ -138,66 +154,19 @@ size_t queue_count(queue_t* queue) {
 }
 
 
-queue_node_t* _queue_new_node(queue_t* queue, void* data) {
-	if(data == NULL) {
-		return NULL;
-	}
-
-	queue_node_t* node = malloc(sizeof(queue_node_t));
-	if(node == NULL) {
-		return NULL;
-	}
-
-	node->data = malloc(queue->data_size);
-	if(node->data == NULL) {
-		return NULL;
-	}
-
-	memcpy(node->data, data, queue->data_size);
-
-	node->next = NULL;
-
-	return node;
-}
-
-
 // push an element on the queue tail
 clib_exit_code_t queue_push(queue_t* queue, void* data) {
 	if(queue == NULL || data == NULL) {
 		return NULL_REF;
 	}
 
-	if(queue->head == NULL) {
-		queue->head = queue->tail = _queue_new_node(queue, data);
-		if(queue->head == NULL) {
-			return OUT_OF_MEM;
-		}
-
-		queue->count++;
-		return OK;
-	}
-
-	if(queue->head == queue->tail) {
-		queue->tail = _queue_new_node(queue, data);
-		if(queue->tail == NULL) {
-			queue->tail = queue->head;
-			return OUT_OF_MEM;
-		}
-
-		queue->head->next = queue->tail;
-
-		queue->count++;
-		return OK;
-	}
-
-	queue->tail->next = _queue_new_node(queue, data);
-	if(queue->tail->next == NULL) {
+	if(queue->count == queue->capacity && queue_reserve(queue, queue->capacity * 2) != OK) {
 		return OUT_OF_MEM;
 	}
 
-	queue->tail = queue->tail->next;
-
+	memcpy(QUEUE_AT(queue, queue->head + queue->count), data, queue->data_size);
 	queue->count++;
+
 	return OK;
 }
 
@@ -208,36 +177,61 @@ clib_exit_code_t queue_pop(queue_t* queue) {
 		return NULL_REF;
 	}
 
-	if(queue->head == NULL) {
+	if(queue->count == 0) {
 		return OK;
 	}
 
+	queue->head = (queue->head + 1) & (queue->capacity - 1);
 	queue->count--;
 
-	if(queue->head == queue->tail) {
-		_queue_free_node(queue->head);
-		free(queue->head);
+	return OK;
+}
+
+
+// get the head of the queue
+const void* queue_head(queue_t* queue) {
+	if(queue == NULL || queue->count == 0) {
+		return NULL;
+	}
+
+	return QUEUE_AT(queue, queue->head);
+}
+
 
-		queue->head = queue->tail = NULL;
+// push count contiguous elements on the queue tail
+clib_exit_code_t queue_push_n(queue_t* queue, const void* data, size_t count) {
+	if(queue == NULL || (data == NULL && count > 0)) {
+		return NULL_REF;
+	}
 
+	if(count == 0) {
 		return OK;
 	}
 
-	queue_node_t* node = queue->head;
-	queue->head = queue->head->next;
+	if(queue_reserve(queue, queue->count + count) != OK) {
+		return OUT_OF_MEM;
+	}
 
-	_queue_free_node(node);
-	free(node);
+	_queue_write(queue, queue->head + queue->count, data, count);
+	queue->count += count;
 
 	return OK;
 }
 
 
-// get the head of the queue
-const void* queue_head(queue_t* queue) {
-	if(queue == NULL || queue->head == NULL) {
-		return NULL;
+// pop up to count elements from the head into out (if not NULL), returns how many were popped
+size_t queue_pop_n(queue_t* queue, void* out, size_t count) {
+	if(queue == NULL) {
+		return 0;
+	}
+
+	count = _min(count, queue->count);
+	if(out != NULL) {
+		_queue_read(queue, queue->head, out, count);
 	}
 
-	return queue->head->data;
-}
\ No newline at end of file
+	queue->head = (queue->head + count) & (queue->capacity - 1);
+	queue->count -= count;
+
+	return count;
+}
@@ -0,0 +1,194 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+A radix heap implementation in C for monotone integer priorities
+*/
+
+#include "../include/radix_heap.h"
+
+#define ENTRY_KEY(entry) (*(uint64_t*)(entry))
+#define ENTRY_DATA(entry) ((char*)(entry) + sizeof(uint64_t))
+
+
+static size_t _radix_heap_bucket(uint64_t last, uint64_t key) {
+	if(key == last)
+		return 0;
+
+	return 64 - __builtin_clzll(key ^ last);
+}
+
+// makes the smallest key the new last and moves its bucket down so bucket 0 is not
+// empty, the heap must not be empty
+static clib_exit_code_t _radix_heap_refill(radix_heap_t* heap) {
+	if(vec_count(heap->buckets[0]) > 0)
+		return OK;
+
+	size_t index = 1;
+	while(vec_count(heap->buckets[index]) == 0)
+		index++;
+
+	vector_t* bucket = heap->buckets[index];
+	size_t count = vec_count(bucket);
+	uint64_t smallest = UINT64_MAX;
+
+	for(size_t i = 0; i < count; i++) {
+		uint64_t key = ENTRY_KEY(vec_at_unchecked(bucket, i));
+		if(key < smallest)
+			smallest = key;
+	}
+
+	// every entry lands in a lower bucket, room is made first so nothing fails halfway
+	size_t moved[RADIX_HEAP_BUCKETS] = {0};
+	for(size_t i = 0; i < count; i++)
+		moved[_radix_heap_bucket(smallest, ENTRY_KEY(vec_at_unchecked(bucket, i)))]++;
+
+	for(size_t b = 0; b < index; b++) {
+		if(moved[b] && vec_reserve(heap->buckets[b], vec_count(heap->buckets[b]) + moved[b]) != OK)
+			return OUT_OF_MEM;
+	}
+
+	heap->last = smallest;
+
+	for(size_t i = 0; i < count; i++) {
+		const void* entry = vec_at_unchecked(bucket, i);
+		vector_t* target = heap->buckets[_radix_heap_bucket(smallest, ENTRY_KEY(entry))];
+		memcpy(vec_emplace_back(target), entry, heap->entry_size);
+	}
+
+	vec_clear(bucket);
+
+	return OK;
+}
+
+radix_heap_t* radix_heap_init(size_t data_size) {
+	radix_heap_t* heap = calloc(1, sizeof(*heap));
+	if(heap == NULL) {
+		printf("\n[radix_heap->radix_heap_init]: Not enough memory to create heap!\n");
+		return NULL;
+	}
+
+	heap->data_size = data_size;
+	heap->entry_size = sizeof(uint64_t) + (data_size + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t);
+
+	for(size_t b = 0; b < RADIX_HEAP_BUCKETS; b++) {
+		heap->buckets[b] = vec_init(0, 0, heap->entry_size);
+		if(heap->buckets[b] == NULL) {
+			printf("\n[radix_heap->radix_heap_init]: Not enough memory to create heap!\n");
+			radix_heap_delete(heap);
+			return NULL;
+		}
+	}
+
+	return heap;
+}
+
+clib_exit_code_t radix_heap_delete(radix_heap_t* heap) {
+	if(heap == NULL) {
+		printf("\n[radix_heap->radix_heap_delete]: Null reference to heap!\n");
+		return NULL_REF;
+	}
+
+	for(size_t b = 0; b < RADIX_HEAP_BUCKETS; b++) {
+		if(heap->buckets[b])
+			vec_delete(heap->buckets[b]);
+	}
+
+	free(heap);
+
+	return OK;
+}
+
+clib_exit_code_t radix_heap_clear(radix_heap_t* heap) {
+	if(heap == NULL) {
+		printf("\n[radix_heap->radix_heap_clear]: Null reference to heap!\n");
+		return NULL_REF;
+	}
+
+	for(size_t b = 0; b < RADIX_HEAP_BUCKETS; b++)
+		vec_clear(heap->buckets[b]);
+
+	heap->last = 0;
+	heap->count = 0;
+
+	return OK;
+}
+
+size_t radix_heap_count(radix_heap_t* heap) {
+	if(heap == NULL)
+		return 0;
+
+	return heap->count;
+}
+
+clib_exit_code_t radix_heap_push(radix_heap_t* heap, uint64_t key, const void* data) {
+	if(heap == NULL || (data == NULL && heap->data_size > 0))
+		return NULL_REF;
+
+	if(key < heap->last)
+		return OUT_OF_BOUNDS;
+
+	void* entry = vec_emplace_back(heap->buckets[_radix_heap_bucket(heap->last, key)]);
+	if(entry == NULL)
+		return OUT_OF_MEM;
+
+	ENTRY_KEY(entry) = key;
+	if(heap->data_size > 0)
+		memcpy(ENTRY_DATA(entry), data, heap->data_size);
+
+	heap->count++;
+
+	return OK;
+}
+
+// only looks for the smallest key, moving it down is left to the pop so last stays
+// the last popped key and the keys between it and the smallest can still be pushed
+const void* radix_heap_top(radix_heap_t* heap, uint64_t* key) {
+	if(heap == NULL || heap->count == 0)
+		return NULL;
+
+	size_t index = 0;
+	while(vec_count(heap->buckets[index]) == 0)
+		index++;
+
+	vector_t* bucket = heap->buckets[index];
+	const void* top = vec_at_unchecked(bucket, vec_count(bucket) - 1);
+
+	// the pop takes the last of the smallest keys once they are in bucket 0, so ties
+	// go to the last one here as well
+	if(index > 0) {
+		for(size_t i = 0; i < vec_count(bucket); i++) {
+			const void* entry = vec_at_unchecked(bucket, i);
+			if(ENTRY_KEY(entry) <= ENTRY_KEY(top))
+				top = entry;
+		}
+	}
+
+	if(key)
+		*key = ENTRY_KEY(top);
+
+	return ENTRY_DATA(top);
+}
+
+clib_exit_code_t radix_heap_pop(radix_heap_t* heap, uint64_t* key, void* data) {
+	if(heap == NULL)
+		return NULL_REF;
+
+	if(heap->count == 0)
+		return OUT_OF_BOUNDS;
+
+	clib_exit_code_t err = _radix_heap_refill(heap);
+	if(err != OK)
+		return err;
+
+	vector_t* bucket = heap->buckets[0];
+	const void* entry = vec_at_unchecked(bucket, vec_count(bucket) - 1);
+
+	if(key)
+		*key = heap->last;
+	if(data && heap->data_size > 0)
+		memcpy(data, ENTRY_DATA(entry), heap->data_size);
+
+	vec_remove_back(bucket);
+	heap->count--;
+
+	return OK;
+}
@@ -0,0 +1,238 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+A concurrent read-mostly ordered map in C
+*/
+
+#include "../include/rcu_map.h"
+
+// the writer swaps the version in and only then bumps the epoch, a reader
+// announces its epoch and only then loads the version, both with sequentially
+// consistent atomics, so a reader the writer does not see afterwards loads the
+// new version, and a reader announcing the new epoch or a later one can not
+// hold the replaced version, which is freed when every open read section
+// started in that epoch or later
+
+typedef struct rcu_map_retired_s {
+	pavl_tree_t* version;
+	uint64_t epoch;
+} rcu_map_retired_t;
+
+
+rcu_map_t* rcu_map_init(unsigned int data_size, unsigned int key_size, int (*comparation)(const void*, const void*),
+		size_t max_readers) {
+	if(comparation == NULL || max_readers == 0)
+		return NULL;
+
+	rcu_map_t* map = aligned_alloc(RCU_MAP_CACHE_LINE, sizeof(rcu_map_t));
+	if(map == NULL) {
+		printf("\n[rcu_map->rcu_map_init]: Not enough memory to create the map!");
+		printf(" Returned NULL\n");
+		return NULL;
+	}
+
+	pavl_tree_t* version = pavl_tree_init(data_size, key_size, comparation);
+	map->retired = queue_init(sizeof(rcu_map_retired_t));
+	map->readers = aligned_alloc(RCU_MAP_CACHE_LINE, max_readers * sizeof(rcu_map_reader_t));
+
+	if(version == NULL || map->retired == NULL || map->readers == NULL) {
+		printf("\n[rcu_map->rcu_map_init]: Not enough memory to create the map!");
+		printf(" Returned NULL\n");
+		pavl_tree_delete(version);
+		queue_delete(map->retired);
+		free(map->readers);
+		free(map);
+		return NULL;
+	}
+
+	for(size_t i = 0; i < max_readers; i++) {
+		atomic_init(&map->readers[i].epoch, 0);
+		atomic_init(&map->readers[i].used, 0);
+	}
+
+	atomic_init(&map->current, version);
+	atomic_init(&map->epoch, 1);
+	atomic_init(&map->count, 0);
+	pthread_mutex_init(&map->write_lock, NULL);
+	map->max_readers = max_readers;
+
+	return map;
+}
+
+void rcu_map_delete(rcu_map_t* map) {
+	if(map == NULL)
+		return;
+
+	rcu_map_retired_t retired;
+	while(queue_pop_n(map->retired, &retired, 1))
+		pavl_tree_delete(retired.version);
+
+	pavl_tree_delete(atomic_load(&map->current));
+	queue_delete(map->retired);
+	pthread_mutex_destroy(&map->write_lock);
+	free(map->readers);
+	free(map);
+}
+
+// READERS
+
+rcu_map_reader_t* rcu_map_reader_register(rcu_map_t* map) {
+	if(map == NULL)
+		return NULL;
+
+	for(size_t i = 0; i < map->max_readers; i++) {
+		int expected = 0;
+		if(atomic_compare_exchange_strong(&map->readers[i].used, &expected, 1))
+			return &map->readers[i];
+	}
+
+	return NULL;
+}
+
+void rcu_map_reader_unregister(rcu_map_t* map, rcu_map_reader_t* reader) {
+	if(map == NULL || reader == NULL)
+		return;
+
+	atomic_store_explicit(&reader->epoch, 0, memory_order_release);
+	atomic_store_explicit(&reader->used, 0, memory_order_release);
+}
+
+void rcu_map_read_lock(rcu_map_t* map, rcu_map_reader_t* reader) {
+	atomic_store(&reader->epoch, atomic_load(&map->epoch));
+}
+
+void rcu_map_read_unlock(rcu_map_reader_t* reader) {
+	atomic_store_explicit(&reader->epoch, 0, memory_order_release);
+}
+
+const pavl_tree_t* rcu_map_version(rcu_map_t* map) {
+	return atomic_load(&map->current);
+}
+
+int rcu_map_search(rcu_map_t* map, rcu_map_reader_t* reader, const void* key, void* data) {
+	if(map == NULL || reader == NULL || key == NULL)
+		return 0;
+
+	rcu_map_read_lock(map, reader);
+
+	pavl_tree_t* version = atomic_load(&map->current);
+	const void* found = pavl_tree_search(version, key);
+	if(found && data)
+		memcpy(data, found, version->data_size);
+
+	rcu_map_read_unlock(reader);
+
+	return found != NULL;
+}
+
+pavl_tree_t* rcu_map_snapshot(rcu_map_t* map, rcu_map_reader_t* reader) {
+	if(map == NULL || reader == NULL)
+		return NULL;
+
+	// the copy holds its own references, so it survives the version being freed
+	rcu_map_read_lock(map, reader);
+	pavl_tree_t* snapshot = pavl_tree_copy(atomic_load(&map->current));
+	rcu_map_read_unlock(reader);
+
+	return snapshot;
+}
+
+int rcu_map_count(rcu_map_t* map) {
+	if(map == NULL)
+		return 0;
+
+	return atomic_load_explicit(&map->count, memory_order_relaxed);
+}
+
+// WRITERS
+
+// frees the replaced versions no open read section can still be using
+static void _rcu_map_reclaim(rcu_map_t* map) {
+	uint64_t oldest = UINT64_MAX;
+
+	for(size_t i = 0; i < map->max_readers; i++) {
+		uint64_t epoch = atomic_load(&map->readers[i].epoch);
+		if(epoch != 0 && epoch < oldest)
+			oldest = epoch;
+	}
+
+	while(queue_count(map->retired) > 0) {
+		const rcu_map_retired_t* retired = queue_head(map->retired);
+		if(retired->epoch > oldest)
+			break;
+
+		pavl_tree_delete(retired->version);
+		queue_pop(map->retired);
+	}
+}
+
+clib_exit_code_t rcu_map_update(rcu_map_t* map, clib_exit_code_t (*update)(pavl_tree_t* draft, void* arg), void* arg) {
+	if(map == NULL || update == NULL)
+		return NULL_REF;
+
+	pthread_mutex_lock(&map->write_lock);
+
+	// only writers free versions, so the current one stays alive while the lock is held
+	pavl_tree_t* current = atomic_load_explicit(&map->current, memory_order_relaxed);
+	pavl_tree_t* draft = pavl_tree_copy(current);
+	if(draft == NULL) {
+		pthread_mutex_unlock(&map->write_lock);
+		return OUT_OF_MEM;
+	}
+
+	clib_exit_code_t status = update(draft, arg);
+	if(status != OK) {
+		pavl_tree_delete(draft);
+		pthread_mutex_unlock(&map->write_lock);
+		return status;
+	}
+
+	// reserved first, so the swap can not be followed by a failed push
+	if(queue_reserve(map->retired, queue_count(map->retired) + 1) != OK) {
+		pavl_tree_delete(draft);
+		pthread_mutex_unlock(&map->write_lock);
+		return OUT_OF_MEM;
+	}
+
+	atomic_store(&map->current, draft);
+	atomic_store_explicit(&map->count, draft->count, memory_order_relaxed);
+
+	rcu_map_retired_t retired = { current, atomic_fetch_add(&map->epoch, 1) + 1 };
+	queue_push(map->retired, &retired);
+
+	_rcu_map_reclaim(map);
+
+	pthread_mutex_unlock(&map->write_lock);
+
+	return OK;
+}
+
+typedef struct rcu_map_change_s {
+	const void* key;
+	const void* data;
+} rcu_map_change_t;
+
+static clib_exit_code_t _rcu_map_insert(pavl_tree_t* draft, void* arg) {
+	rcu_map_change_t* change = arg;
+	return pavl_tree_insert(draft, change->key, change->data);
+}
+
+static clib_exit_code_t _rcu_map_erase(pavl_tree_t* draft, void* arg) {
+	rcu_map_change_t* change = arg;
+	return pavl_tree_erase(draft, change->key);
+}
+
+clib_exit_code_t rcu_map_insert(rcu_map_t* map, const void* key, const void* data) {
+	if(key == NULL || data == NULL)
+		return NULL_REF;
+
+	rcu_map_change_t change = { key, data };
+	return rcu_map_update(map, _rcu_map_insert, &change);
+}
+
+clib_exit_code_t rcu_map_erase(rcu_map_t* map, const void* key) {
+	if(key == NULL)
+		return NULL_REF;
+
+	rcu_map_change_t change = { key, NULL };
+	return rcu_map_update(map, _rcu_map_erase, &change);
+}
@@ -0,0 +1,422 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+Pattern-defeating quicksort in C
+
+Port of Orson Peters' pdqsort to untyped arrays: insertion sort for small
+ranges, median of 3 / ninther pivots, branchless block partitioning,
+detection of already sorted runs, pattern breaking shuffles on unbalanced
+partitions and a heapsort fallback bounding the worst case.
+*/
+
+#include "../include/sort.h"
+
+#define INSERTION_SORT_THRESHOLD 24
+#define NINTHER_THRESHOLD 128
+#define PARTIAL_INSERTION_SORT_LIMIT 8
+#define BLOCK_SIZE 64
+
+typedef struct sort_ctx_s {
+	size_t size;
+	uint8_t (*compare)(const void*, const void*);
+	char* pivot;
+	char* tmp;
+	char* swap;
+} sort_ctx_t;
+
+typedef struct partition_s {
+	char* pivot_pos;
+	int already_partitioned;
+} partition_t;
+
+
+#define AT(p, i) ((p) + (ptrdiff_t)(i) * (ptrdiff_t)ctx->size)
+#define LESS(a, b) (ctx->compare((b), (a)))
+#define MOVE(dst, src) memcpy((dst), (src), ctx->size)
+
+
+static inline void _swap(const sort_ctx_t* ctx, char* a, char* b) {
+	MOVE(ctx->swap, a);
+	MOVE(a, b);
+	MOVE(b, ctx->swap);
+}
+
+
+static void _insertion_sort(const sort_ctx_t* ctx, char* begin, char* end) {
+	if(begin == end)
+		return;
+
+	for(char* cur = AT(begin, 1); cur != end; cur = AT(cur, 1)) {
+		char* sift = cur;
+		char* sift_1 = AT(cur, -1);
+
+		if(LESS(sift, sift_1)) {
+			MOVE(ctx->tmp, sift);
+			do {
+				MOVE(sift, sift_1);
+				sift = sift_1;
+			} while(sift != begin && LESS(ctx->tmp, (sift_1 = AT(sift_1, -1))));
+			MOVE(sift, ctx->tmp);
+		}
+	}
+}
+
+
+// the element before begin must be smaller or equal to every element of the range
+static void _unguarded_insertion_sort(const sort_ctx_t* ctx, char* begin, char* end) {
+	if(begin == end)
+		return;
+
+	for(char* cur = AT(begin, 1); cur != end; cur = AT(cur, 1)) {
+		char* sift = cur;
+		char* sift_1 = AT(cur, -1);
+
+		if(LESS(sift, sift_1)) {
+			MOVE(ctx->tmp, sift);
+			do {
+				MOVE(sift, sift_1);
+				sift = sift_1;
+			} while(LESS(ctx->tmp, (sift_1 = AT(sift_1, -1))));
+			MOVE(sift, ctx->tmp);
+		}
+	}
+}
+
+
+// insertion sort giving up after a few moves, returns 1 if the range got sorted
+static int _partial_insertion_sort(const sort_ctx_t* ctx, char* begin, char* end) {
+	if(begin == end)
+		return 1;
+
+	size_t limit = 0;
+	for(char* cur = AT(begin, 1); cur != end; cur = AT(cur, 1)) {
+		char* sift = cur;
+		char* sift_1 = AT(cur, -1);
+
+		if(LESS(sift, sift_1)) {
+			MOVE(ctx->tmp, sift);
+			do {
+				MOVE(sift, sift_1);
+				sift = sift_1;
+			} while(sift != begin && LESS(ctx->tmp, (sift_1 = AT(sift_1, -1))));
+			MOVE(sift, ctx->tmp);
+			limit += (cur - sift) / ctx->size;
+		}
+
+		if(limit > PARTIAL_INSERTION_SORT_LIMIT)
+			return 0;
+	}
+
+	return 1;
+}
+
+
+static inline void _sort2(const sort_ctx_t* ctx, char* a, char* b) {
+	if(LESS(b, a))
+		_swap(ctx, a, b);
+}
+
+
+static inline void _sort3(const sort_ctx_t* ctx, char* a, char* b, char* c) {
+	_sort2(ctx, a, b);
+	_sort2(ctx, b, c);
+	_sort2(ctx, a, b);
+}
+
+
+static void _sift_down(const sort_ctx_t* ctx, char* begin, size_t count, size_t it) {
+	MOVE(ctx->tmp, AT(begin, it));
+
+	size_t child;
+	while((child = 2 * it + 1) < count) {
+		if(child + 1 < count && LESS(AT(begin, child), AT(begin, child + 1)))
+			child++;
+		if(!LESS(ctx->tmp, AT(begin, child)))
+			break;
+		MOVE(AT(begin, it), AT(begin, child));
+		it = child;
+	}
+
+	MOVE(AT(begin, it), ctx->tmp);
+}
+
+
+static void _heap_sort(const sort_ctx_t* ctx, char* begin, char* end) {
+	size_t count = (end - begin) / ctx->size;
+
+	for(size_t i = count / 2; i-- > 0;)
+		_sift_down(ctx, begin, count, i);
+
+	for(size_t last = count - 1; last > 0; last--) {
+		_swap(ctx, begin, AT(begin, last));
+		_sift_down(ctx, begin, last, 0);
+	}
+}
+
+
+// swaps the elements found on the wrong sides by the block partition
+static void _swap_offsets(const sort_ctx_t* ctx, char* first, char* last,
+		unsigned char* offsets_l, unsigned char* offsets_r, size_t num, int use_swaps) {
+	if(use_swaps) {
+		// needed for descending inputs to stay O(n)
+		for(size_t i = 0; i < num; i++)
+			_swap(ctx, AT(first, offsets_l[i]), AT(last, -(ptrdiff_t)offsets_r[i]));
+	} else if(num > 0) {
+		// cyclic permutation, one move per element instead of three
+		char* l = AT(first, offsets_l[0]);
+		char* r = AT(last, -(ptrdiff_t)offsets_r[0]);
+		MOVE(ctx->tmp, l);
+		MOVE(l, r);
+		for(size_t i = 1; i < num; i++) {
+			l = AT(first, offsets_l[i]);
+			MOVE(r, l);
+			r = AT(last, -(ptrdiff_t)offsets_r[i]);
+			MOVE(l, r);
+		}
+		MOVE(r, ctx->tmp);
+	}
+}
+
+
+// partitions around *begin, elements equal to the pivot go to the right
+// the comparisons only feed counters, so the loops have no data dependent branches
+static partition_t _partition_right_branchless(const sort_ctx_t* ctx, char* begin, char* end) {
+	MOVE(ctx->pivot, begin);
+	char* pivot = ctx->pivot;
+	char* first = begin;
+	char* last = end;
+
+	// find the first element >= pivot, the median of 3 guarantees one exists
+	while(LESS((first = AT(first, 1)), pivot));
+
+	// find the last element < pivot, guarded only if no element was smaller
+	if(AT(first, -1) == begin)
+		while(first < last && !LESS((last = AT(last, -1)), pivot));
+	else
+		while(!LESS((last = AT(last, -1)), pivot));
+
+	int already_partitioned = first >= last;
+
+	if(!already_partitioned) {
+		_swap(ctx, first, last);
+		first = AT(first, 1);
+
+		unsigned char offsets_l[BLOCK_SIZE];
+		unsigned char offsets_r[BLOCK_SIZE];
+		char* offsets_l_base = first;
+		char* offsets_r_base = last;
+		size_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+
+		while(first < last) {
+			// how many elements are considered for each offset block
+			size_t num_unknown = (last - first) / ctx->size;
+			size_t left_split = num_l == 0 ? (num_r == 0 ? num_unknown / 2 : num_unknown) : 0;
+			size_t right_split = num_r == 0 ? (num_unknown - left_split) : 0;
+
+			left_split = _min(left_split, BLOCK_SIZE);
+			for(size_t i = 0; i < left_split; i++) {
+				offsets_l[num_l] = i;
+				num_l += !LESS(first, pivot);
+				first = AT(first, 1);
+			}
+
+			right_split = _min(right_split, BLOCK_SIZE);
+			for(size_t i = 0; i < right_split;) {
+				offsets_r[num_r] = ++i;
+				last = AT(last, -1);
+				num_r += LESS(last, pivot);
+			}
+
+			size_t num = _min(num_l, num_r);
+			_swap_offsets(ctx, offsets_l_base, offsets_r_base, offsets_l + start_l, offsets_r + start_r,
+				num, num_l == num_r);
+			num_l -= num;
+			num_r -= num;
+			start_l += num;
+			start_r += num;
+
+			if(num_l == 0) {
+				start_l = 0;
+				offsets_l_base = first;
+			}
+			if(num_r == 0) {
+				start_r = 0;
+				offsets_r_base = last;
+			}
+		}
+
+		// [first, last) is fully classified, move the leftovers of one block
+		if(num_l) {
+			while(num_l--) {
+				last = AT(last, -1);
+				_swap(ctx, AT(offsets_l_base, offsets_l[start_l + num_l]), last);
+			}
+			first = last;
+		}
+		if(num_r) {
+			while(num_r--) {
+				_swap(ctx, AT(offsets_r_base, -(ptrdiff_t)offsets_r[start_r + num_r]), first);
+				first = AT(first, 1);
+			}
+			last = first;
+		}
+	}
+
+	partition_t result;
+	result.pivot_pos = AT(first, -1);
+	result.already_partitioned = already_partitioned;
+
+	MOVE(begin, result.pivot_pos);
+	MOVE(result.pivot_pos, pivot);
+
+	return result;
+}
+
+
+// partitions around *begin, elements equal to the pivot go to the left
+// used when the pivot equals the element before the range, so the whole
+// run of equal elements ends up in place at once
+static char* _partition_left(const sort_ctx_t* ctx, char* begin, char* end) {
+	MOVE(ctx->pivot, begin);
+	char* pivot = ctx->pivot;
+	char* first = begin;
+	char* last = end;
+
+	while(LESS(pivot, (last = AT(last, -1))));
+
+	if(AT(last, 1) == end)
+		while(first < last && !LESS(pivot, (first = AT(first, 1))));
+	else
+		while(!LESS(pivot, (first = AT(first, 1))));
+
+	while(first < last) {
+		_swap(ctx, first, last);
+		while(LESS(pivot, (last = AT(last, -1))));
+		while(!LESS(pivot, (first = AT(first, 1))));
+	}
+
+	MOVE(begin, last);
+	MOVE(last, pivot);
+
+	return last;
+}
+
+
+static void _pdq_sort_loop(const sort_ctx_t* ctx, char* begin, char* end, int bad_allowed, int leftmost) {
+	while(1) {
+		size_t size = (end - begin) / ctx->size;
+
+		if(size < INSERTION_SORT_THRESHOLD) {
+			if(leftmost)
+				_insertion_sort(ctx, begin, end);
+			else
+				_unguarded_insertion_sort(ctx, begin, end);
+			return;
+		}
+
+		// pivot is the median of 3, or the pseudo median of 9 for large ranges
+		size_t s2 = size / 2;
+		if(size > NINTHER_THRESHOLD) {
+			_sort3(ctx, begin, AT(begin, s2), AT(end, -1));
+			_sort3(ctx, AT(begin, 1), AT(begin, s2 - 1), AT(end, -2));
+			_sort3(ctx, AT(begin, 2), AT(begin, s2 + 1), AT(end, -3));
+			_sort3(ctx, AT(begin, s2 - 1), AT(begin, s2), AT(begin, s2 + 1));
+			_swap(ctx, begin, AT(begin, s2));
+		} else {
+			_sort3(ctx, AT(begin, s2), begin, AT(end, -1));
+		}
+
+		// the pivot equals the element before the range: everything equal to
+		// it is already in place, only the greater elements remain
+		if(!leftmost && !LESS(AT(begin, -1), begin)) {
+			begin = AT(_partition_left(ctx, begin, end), 1);
+			continue;
+		}
+
+		partition_t part = _partition_right_branchless(ctx, begin, end);
+		char* pivot_pos = part.pivot_pos;
+
+		size_t l_size = (pivot_pos - begin) / ctx->size;
+		size_t r_size = (end - AT(pivot_pos, 1)) / ctx->size;
+		int highly_unbalanced = l_size < size / 8 || r_size < size / 8;
+
+		if(highly_unbalanced) {
+			// too many bad pivots, fall back to heapsort for O(n log n)
+			if(--bad_allowed == 0) {
+				_heap_sort(ctx, begin, end);
+				return;
+			}
+
+			// break patterns that fool the pivot selection
+			if(l_size >= INSERTION_SORT_THRESHOLD) {
+				_swap(ctx, begin, AT(begin, l_size / 4));
+				_swap(ctx, AT(pivot_pos, -1), AT(pivot_pos, -(ptrdiff_t)(l_size / 4)));
+				if(l_size > NINTHER_THRESHOLD) {
+					_swap(ctx, AT(begin, 1), AT(begin, l_size / 4 + 1));
+					_swap(ctx, AT(begin, 2), AT(begin, l_size / 4 + 2));
+					_swap(ctx, AT(pivot_pos, -2), AT(pivot_pos, -(ptrdiff_t)(l_size / 4 + 1)));
+					_swap(ctx, AT(pivot_pos, -3), AT(pivot_pos, -(ptrdiff_t)(l_size / 4 + 2)));
+				}
+			}
+			if(r_size >= INSERTION_SORT_THRESHOLD) {
+				_swap(ctx, AT(pivot_pos, 1), AT(pivot_pos, 1 + r_size / 4));
+				_swap(ctx, AT(end, -1), AT(end, -(ptrdiff_t)(r_size / 4)));
+				if(r_size > NINTHER_THRESHOLD) {
+					_swap(ctx, AT(pivot_pos, 2), AT(pivot_pos, 2 + r_size / 4));
+					_swap(ctx, AT(pivot_pos, 3), AT(pivot_pos, 3 + r_size / 4));
+					_swap(ctx, AT(end, -2), AT(end, -(ptrdiff_t)(1 + r_size / 4)));
+					_swap(ctx, AT(end, -3), AT(end, -(ptrdiff_t)(2 + r_size / 4)));
+				}
+			}
+		} else if(part.already_partitioned
+			&& _partial_insertion_sort(ctx, begin, pivot_pos)
+			&& _partial_insertion_sort(ctx, AT(pivot_pos, 1), end)) {
+			// a balanced partition that moved nothing: the range was probably
+			// sorted, and the insertion sorts confirmed it cheaply
+			return;
+		}
+
+		// recurse on the left part, loop on the right one
+		_pdq_sort_loop(ctx, begin, pivot_pos, bad_allowed, leftmost);
+		begin = AT(pivot_pos, 1);
+		leftmost = 0;
+	}
+}
+
+
+clib_exit_code_t pdq_sort(void* array, size_t elem_size, size_t begin, size_t end, uint8_t (*compare)(const void*, const void*)) {
+	if(array == NULL || begin > end || compare == NULL) {
+		return NULL_REF;
+	}
+
+	size_t count = end - begin + 1;
+	if(count < 2)
+		return OK;
+
+	sort_ctx_t ctx;
+	ctx.size = elem_size;
+	ctx.compare = compare;
+
+	char scratch[3 * 64];
+	char* buffer = scratch;
+	if(3 * elem_size > sizeof(scratch)) {
+		buffer = malloc(3 * elem_size);
+		if(buffer == NULL)
+			return OUT_OF_MEM;
+	}
+
+	ctx.pivot = buffer;
+	ctx.tmp = buffer + elem_size;
+	ctx.swap = buffer + 2 * elem_size;
+
+	int bad_allowed = 0;
+	while(count >> bad_allowed)
+		bad_allowed++;
+
+	char* first = (char*)array + begin * elem_size;
+	_pdq_sort_loop(&ctx, first, first + count * elem_size, bad_allowed, 1);
+
+	if(buffer != scratch)
+		free(buffer);
+
+	return OK;
+}
@@ -0,0 +1,152 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+A lock-free single producer / single consumer ring queue in C
+*/
+
+#include "../include/spsc_ring.h"
+
+// head and tail grow forever, the slot is the index masked by capacity - 1
+
+
+spsc_ring_t* spsc_ring_init(size_t capacity, size_t data_size) {
+	if (data_size == 0)
+		return NULL;
+
+	size_t pow2 = 2;
+	while (pow2 < capacity)
+		pow2 *= 2;
+
+	spsc_ring_t* ring = aligned_alloc(SPSC_CACHE_LINE, sizeof(spsc_ring_t));
+	if (!ring)
+		return NULL;
+
+	ring->data = malloc(pow2 * data_size);
+	if (!ring->data) {
+		free(ring);
+		return NULL;
+	}
+
+	atomic_init(&ring->head, 0);
+	atomic_init(&ring->tail, 0);
+	atomic_init(&ring->closed, 0);
+	ring->tail_cache = 0;
+	ring->head_cache = 0;
+	ring->capacity = pow2;
+	ring->data_size = data_size;
+
+	return ring;
+}
+
+
+clib_exit_code_t spsc_ring_delete(spsc_ring_t* ring) {
+	if (!ring)
+		return NULL_REF;
+
+	free(ring->data);
+	free(ring);
+
+	return OK;
+}
+
+
+// copies count elements between out and the slots starting at index, handling the wrap
+static void _spsc_copy(spsc_ring_t* ring, size_t index, void* buffer, size_t count, int to_ring) {
+	size_t start = index & (ring->capacity - 1);
+	size_t first = _min(count, ring->capacity - start);
+	char* slot = ring->data + start * ring->data_size;
+	char* rest = (char*)buffer + first * ring->data_size;
+
+	if (to_ring) {
+		memcpy(slot, buffer, first * ring->data_size);
+		memcpy(ring->data, rest, (count - first) * ring->data_size);
+	} else {
+		memcpy(buffer, slot, first * ring->data_size);
+		memcpy(rest, ring->data, (count - first) * ring->data_size);
+	}
+}
+
+
+size_t spsc_ring_push_n(spsc_ring_t* ring, const void* data, size_t count) {
+	if (!ring || !data || count == 0)
+		return 0;
+
+	size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	size_t free_slots = ring->capacity - (tail - ring->head_cache);
+
+	// only reload the consumer's index when the cached one says there is no room
+	if (free_slots < count) {
+		ring->head_cache = atomic_load_explicit(&ring->head, memory_order_acquire);
+		free_slots = ring->capacity - (tail - ring->head_cache);
+	}
+
+	count = _min(count, free_slots);
+	if (count == 0)
+		return 0;
+
+	_spsc_copy(ring, tail, (void*)data, count, 1);
+	atomic_store_explicit(&ring->tail, tail + count, memory_order_release);
+
+	return count;
+}
+
+
+uint8_t spsc_ring_push(spsc_ring_t* ring, const void* data) {
+	return spsc_ring_push_n(ring, data, 1) == 1;
+}
+
+
+size_t spsc_ring_pop_n(spsc_ring_t* ring, void* out, size_t count) {
+	if (!ring || !out || count == 0)
+		return 0;
+
+	size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	size_t available = ring->tail_cache - head;
+
+	if (available < count) {
+		ring->tail_cache = atomic_load_explicit(&ring->tail, memory_order_acquire);
+		available = ring->tail_cache - head;
+	}
+
+	count = _min(count, available);
+	if (count == 0)
+		return 0;
+
+	_spsc_copy(ring, head, out, count, 0);
+	atomic_store_explicit(&ring->head, head + count, memory_order_release);
+
+	return count;
+}
+
+
+uint8_t spsc_ring_pop(spsc_ring_t* ring, void* out) {
+	return spsc_ring_pop_n(ring, out, 1) == 1;
+}
+
+
+void spsc_ring_close(spsc_ring_t* ring) {
+	if (ring)
+		atomic_store_explicit(&ring->closed, 1, memory_order_release);
+}
+
+
+uint8_t spsc_ring_drained(spsc_ring_t* ring) {
+	if (!ring)
+		return 1;
+
+	// closed must be read first, so a push made before closing is seen by the tail load
+	if (!atomic_load_explicit(&ring->closed, memory_order_acquire))
+		return 0;
+
+	return atomic_load_explicit(&ring->tail, memory_order_acquire) == atomic_load_explicit(&ring->head, memory_order_relaxed);
+}
+
+
+size_t spsc_ring_count(spsc_ring_t* ring) {
+	if (!ring)
+		return 0;
+
+	size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+	return tail - head;
+}
@@ -1,5 +1,51 @@
 #include "./../include/stack.h"
 
+#define STACK_CHUNK_MIN 16
+#define STACK_CHUNK_MAX_BYTES (1 << 20)
+
+
+stack_chunk_t* _stack_create_chunk(stack_t* stack, size_t capacity) {
+	stack_chunk_t* chunk = malloc(sizeof(stack_chunk_t) + capacity * stack->data_size);
+	if (!chunk) {
+		return NULL;
+	}
+
+	chunk->prev = NULL;
+	chunk->capacity = capacity;
+	chunk->used = 0;
+
+	return chunk;
+}
+
+
+// capacity of the chunk pushed over the current top, doubling up to ~1MB per chunk
+size_t _stack_next_capacity(stack_t* stack) {
+	if (!stack->top)
+		return STACK_CHUNK_MIN;
+
+	size_t max_capacity = _max(STACK_CHUNK_MIN, STACK_CHUNK_MAX_BYTES / _max(stack->data_size, 1));
+
+	return _min(2 * stack->top->capacity, _max(max_capacity, stack->top->capacity));
+}
+
+
+void _stack_free_chunks(stack_t* stack) {
+	stack_chunk_t* chunk = stack->top;
+
+	while (chunk != NULL) {
+		stack_chunk_t* prev = chunk->prev;
+		free(chunk);
+		chunk = prev;
+	}
+
+	free(stack->spare);
+
+	stack->top = NULL;
+	stack->spare = NULL;
+	stack->count = 0;
+}
+
+
 // initialize an empty stack
 stack_t* stack_init(size_t data_size) {
 	stack_t* stack = malloc(sizeof(stack_t));
@@ -7,7 +53,8 @@ stack_t* stack_init(size_t data_size) {
 		return NULL;
 
 	stack->count = 0;
-	stack->root = NULL;
+	stack->top = NULL;
+	stack->spare = NULL;
 	stack->data_size = data_size;
 
 	return stack;
@@ -20,16 +67,7 @@ clib_exit_code_t stack_delete(stack_t* stack) {
 		return NULL_REF;
 	}
 
-	stack_node_t* node = stack->root;
-
-	while (node != NULL) {
-		stack_node_t* now = node->next;
-		if (node->data)
-			free(node->data);
-		free(node);
-		node = now;
-	}
-
+	_stack_free_chunks(stack);
 	free(stack);
 
 	return OK;
@@ -38,41 +76,17 @@ clib_exit_code_t stack_delete(stack_t* stack) {
 
 // swap the memory of 2 stacks
 clib_exit_code_t stack_swap(stack_t* a, stack_t* b) {
-	stack_node_t* root_a = a->root;
-	size_t data_size_a = a->data_size;
-	size_t count_a = a->count;
-
-	a->root = b->root;
-	a->data_size = b->data_size;
-	a->count = b->count;
+	if (!a || !b)
+		return NULL_REF;
 
-	b->root = root_a;
-	b->data_size = data_size_a;
-	b->count = count_a;
+	stack_t tmp = *a;
+	*a = *b;
+	*b = tmp;
 
 	return OK;
 }
 
 
-stack_node_t* _stack_create_node(stack_t* stack, void* data) {
-	stack_node_t* node = malloc(sizeof(stack_node_t*));
-	if (!node) {
-		return NULL;
-	}
-
-	node->next = NULL;
-	node->data = malloc(stack->data_size);
-	if (!node->data) {
-		free(node);
-		return NULL;
-	}
-
-	memcpy(node->data, data, stack->data_size);
-
-	return node;
-}
-
-
 // make an exact copy of a stack
 stack_t* stack_copy(stack_t* stack) {
 	if (!stack) {
@@ -84,22 +98,24 @@ stack_t* stack_copy(stack_t* stack) {
 		return NULL;
 	}
 
-	stack_node_t* curr = stack->root;
-	copy->root = _stack_create_node(copy, curr->data);
-	stack_node_t* copy_curr = copy->root;
-	curr = curr->next;
+	if (stack->count == 0)
+		return copy;
 
-	while (curr != NULL) {
-		copy_curr->next = _stack_create_node(copy, curr->data);
-		if (!copy_curr->next) {
-			stack_delete(copy);
-			return NULL;
-		}
+	// the copy gets all elements in a single chunk
+	copy->top = _stack_create_chunk(copy, _max(stack->count, STACK_CHUNK_MIN));
+	if (!copy->top) {
+		stack_delete(copy);
+		return NULL;
+	}
 
-		copy_curr = copy_curr->next;
-		curr = curr->next;
+	// chunks go from top to bottom, so fill the destination from its end
+	size_t pos = stack->count;
+	for (stack_chunk_t* chunk = stack->top; chunk != NULL; chunk = chunk->prev) {
+		pos -= chunk->used;
+		memcpy(copy->top->data + pos * stack->data_size, chunk->data, chunk->used * stack->data_size);
 	}
 
+	copy->top->used = stack->count;
 	copy->count = stack->count;
 
 	return copy;
@@ -108,18 +124,10 @@ stack_t* stack_copy(stack_t* stack) {
 
 // clear all elements in stack
 clib_exit_code_t stack_clear(stack_t* stack) {
-	stack_node_t* node = stack->root;
-
-	while (node != NULL) {
-		stack_node_t* now = node->next;
-		if (node->data)
-			free(node->data);
-		free(node);
-		node = now;
-	}
+	if (!stack)
+		return NULL_REF;
 
-	stack->root = NULL;
-	stack->count = 0;
+	_stack_free_chunks(stack);
 
 	return OK;
 }
@@ -138,20 +146,29 @@ clib_exit_code_t stack_push(stack_t* stack, void* data) {
 	if (!stack || !data)
 		return NULL_REF;
 
-	stack_node_t* node = _stack_create_node(stack, data);
-	if (!node) {
-		return OUT_OF_MEM;
-	}
+	stack_chunk_t* top = stack->top;
 
-	stack->count++;
+	if (!top || top->used == top->capacity) {
+		size_t capacity = _stack_next_capacity(stack);
+		stack_chunk_t* chunk = stack->spare;
 
-	if (!stack->root) {
-		stack->root = node;
-		return OK;
+		if (chunk && chunk->capacity >= capacity) {
+			stack->spare = NULL;
+		} else {
+			chunk = _stack_create_chunk(stack, capacity);
+			if (!chunk) {
+				return OUT_OF_MEM;
+			}
+		}
+
+		chunk->prev = top;
+		chunk->used = 0;
+		stack->top = top = chunk;
 	}
 
-	node->next = stack->root;
-	stack->root = node;
+	memcpy(top->data + top->used * stack->data_size, data, stack->data_size);
+	top->used++;
+	stack->count++;
 
 	return OK;
 }
@@ -162,14 +179,18 @@ clib_exit_code_t stack_pop(stack_t* stack) {
 	if (!stack)
 		return NULL_REF;
 
-	if (!stack->root)
+	if (!stack->top)
 		return OK;
 
-	stack_node_t* new_root = stack->root->next;
-	free(stack->root->data);
-	free(stack->root);
+	stack_chunk_t* top = stack->top;
+	top->used--;
 	stack->count--;
-	stack->root = new_root;
+
+	if (top->used == 0) {
+		stack->top = top->prev;
+		free(stack->spare);
+		stack->spare = top;
+	}
 
 	return OK;
 }
@@ -177,8 +198,8 @@ clib_exit_code_t stack_pop(stack_t* stack) {
 
 // get the value of the top of the stack
 const void* stack_top(stack_t* stack) {
-	if (!stack)
+	if (!stack || !stack->top)
 		return NULL;
 
-	return stack->root->data;
-}
\ No newline at end of file
+	return stack->top->data + (stack->top->used - 1) * stack->data_size;
+}
@@ -0,0 +1,455 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+A work-stealing thread pool in C
+
+Every worker owns a Chase-Lev deque (Chase & Lev 2005, with the C11
+orderings of Le et al. 2013). Spawned tasks go to the bottom of the
+spawning worker's deque, idle workers steal from the top of random
+victims. Threads outside the pool queue their tasks in a locked inject
+queue. A join runs other tasks until the awaited one is done, so
+recursive fork/join never blocks a worker.
+*/
+
+#include <sched.h>
+#include <unistd.h>
+
+#include "../include/thread_pool.h"
+
+#define TP_DEQUE_MIN 64
+// failed searches before an idle worker goes to sleep
+#define TP_SPINS 64
+
+// worker running on this thread, NULL outside of any pool
+static _Thread_local tp_worker_t* _tp_current = NULL;
+
+
+// DEQUE
+
+static tp_array_t* _tp_array_init(size_t size) {
+	tp_array_t* array = malloc(sizeof(tp_array_t) + size * sizeof(_Atomic(tp_task_t*)));
+	if (!array)
+		return NULL;
+
+	array->size = size;
+	array->retired = NULL;
+
+	return array;
+}
+
+static clib_exit_code_t _tp_deque_init(tp_deque_t* deque) {
+	tp_array_t* array = _tp_array_init(TP_DEQUE_MIN);
+	if (!array)
+		return OUT_OF_MEM;
+
+	atomic_init(&deque->top, 0);
+	atomic_init(&deque->bottom, 0);
+	atomic_init(&deque->array, array);
+
+	return OK;
+}
+
+static void _tp_deque_free(tp_deque_t* deque) {
+	tp_array_t* array = atomic_load_explicit(&deque->array, memory_order_relaxed);
+
+	while (array) {
+		tp_array_t* retired = array->retired;
+		free(array);
+		array = retired;
+	}
+}
+
+// owner only
+static clib_exit_code_t _tp_deque_push(tp_deque_t* deque, tp_task_t* task) {
+	long long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+	long long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+	tp_array_t* array = atomic_load_explicit(&deque->array, memory_order_relaxed);
+
+	if (bottom - top > (long long)array->size - 1) {
+		tp_array_t* bigger = _tp_array_init(2 * array->size);
+		if (!bigger)
+			return OUT_OF_MEM;
+
+		for (long long i = top; i < bottom; i++) {
+			tp_task_t* moved = atomic_load_explicit(&array->tasks[i & (array->size - 1)], memory_order_relaxed);
+			atomic_store_explicit(&bigger->tasks[i & (bigger->size - 1)], moved, memory_order_relaxed);
+		}
+
+		bigger->retired = array;
+		atomic_store_explicit(&deque->array, bigger, memory_order_release);
+		array = bigger;
+	}
+
+	atomic_store_explicit(&array->tasks[bottom & (array->size - 1)], task, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+
+	return OK;
+}
+
+// owner only, newest task first
+static tp_task_t* _tp_deque_take(tp_deque_t* deque) {
+	long long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+	tp_array_t* array = atomic_load_explicit(&deque->array, memory_order_relaxed);
+	atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	long long top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+	tp_task_t* task = NULL;
+	if (top <= bottom) {
+		task = atomic_load_explicit(&array->tasks[bottom & (array->size - 1)], memory_order_relaxed);
+		if (top == bottom) {
+			// last task, race the thieves for it
+			if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+					memory_order_seq_cst, memory_order_relaxed))
+				task = NULL;
+			atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+		}
+	} else {
+		atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+	}
+
+	return task;
+}
+
+// any thread, oldest task first
+static tp_task_t* _tp_deque_steal(tp_deque_t* deque) {
+	long long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	long long bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+	if (top >= bottom)
+		return NULL;
+
+	tp_array_t* array = atomic_load_explicit(&deque->array, memory_order_acquire);
+	tp_task_t* task = atomic_load_explicit(&array->tasks[top & (array->size - 1)], memory_order_relaxed);
+
+	if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+			memory_order_seq_cst, memory_order_relaxed))
+		return NULL;
+
+	return task;
+}
+
+
+// SCHEDULER
+
+static tp_worker_t* _tp_self(thread_pool_t* pool) {
+	if (_tp_current && _tp_current->pool == pool)
+		return _tp_current;
+	return NULL;
+}
+
+static uint64_t _tp_random(tp_worker_t* self, uint64_t* seed) {
+	uint64_t* state = self ? &self->seed : seed;
+
+	// xorshift64
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+
+	return *state;
+}
+
+static void _tp_execute(tp_task_t* task) {
+	task->function(task->arg);
+	atomic_store_explicit(&task->done, 1, memory_order_release);
+}
+
+static tp_task_t* _tp_inject_take(thread_pool_t* pool) {
+	if (atomic_load_explicit(&pool->injected, memory_order_acquire) == 0)
+		return NULL;
+
+	tp_task_t* task = NULL;
+
+	pthread_mutex_lock(&pool->inject_lock);
+	if (queue_count(pool->inject)) {
+		task = *(tp_task_t* const*)queue_head(pool->inject);
+		queue_pop(pool->inject);
+		atomic_fetch_sub(&pool->injected, 1);
+	}
+	pthread_mutex_unlock(&pool->inject_lock);
+
+	return task;
+}
+
+// own deque first, then the tasks of outside threads, then random victims
+static tp_task_t* _tp_find(thread_pool_t* pool, tp_worker_t* self, uint64_t* seed) {
+	tp_task_t* task = NULL;
+
+	if (self)
+		task = _tp_deque_take(&self->deque);
+
+	if (!task)
+		task = _tp_inject_take(pool);
+
+	for (size_t i = 0; !task && pool->count > 0 && i < 2 * pool->count; i++) {
+		tp_worker_t* victim = &pool->workers[_tp_random(self, seed) % pool->count];
+		if (victim != self)
+			task = _tp_deque_steal(&victim->deque);
+	}
+
+	if (task)
+		atomic_fetch_sub(&pool->queued, 1);
+
+	return task;
+}
+
+static void _tp_sleep(thread_pool_t* pool) {
+	pthread_mutex_lock(&pool->sleep_lock);
+	atomic_fetch_add(&pool->sleepers, 1);
+
+	// paired with the queued increment and sleepers check in _tp_wake
+	while (atomic_load(&pool->queued) == 0 && !atomic_load(&pool->stop))
+		pthread_cond_wait(&pool->wake, &pool->sleep_lock);
+
+	atomic_fetch_sub(&pool->sleepers, 1);
+	pthread_mutex_unlock(&pool->sleep_lock);
+}
+
+// the task was counted in queued before being published
+static void _tp_wake(thread_pool_t* pool) {
+	if (atomic_load(&pool->sleepers)) {
+		pthread_mutex_lock(&pool->sleep_lock);
+		pthread_cond_signal(&pool->wake);
+		pthread_mutex_unlock(&pool->sleep_lock);
+	}
+}
+
+static void* _tp_worker_main(void* arg) {
+	tp_worker_t* self = arg;
+	thread_pool_t* pool = self->pool;
+	_tp_current = self;
+
+	// wait for thread_pool_init to settle the worker count
+	pthread_mutex_lock(&pool->sleep_lock);
+	pthread_mutex_unlock(&pool->sleep_lock);
+
+	size_t misses = 0;
+	while (!atomic_load_explicit(&pool->stop, memory_order_relaxed)) {
+		tp_task_t* task = _tp_find(pool, self, NULL);
+		if (task) {
+			_tp_execute(task);
+			misses = 0;
+		} else if (++misses < TP_SPINS) {
+			sched_yield();
+		} else {
+			_tp_sleep(pool);
+			misses = 0;
+		}
+	}
+
+	return NULL;
+}
+
+
+// THREAD POOL
+
+thread_pool_t* thread_pool_init(size_t threads) {
+	if (threads == 0) {
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = cores > 0 ? cores : 1;
+	}
+
+	thread_pool_t* pool = malloc(sizeof(thread_pool_t));
+	if (!pool)
+		return NULL;
+
+	pool->workers = aligned_alloc(TP_CACHE_LINE, threads * sizeof(tp_worker_t));
+	pool->inject = queue_init(sizeof(tp_task_t*));
+	if (!pool->workers || !pool->inject) {
+		free(pool->workers);
+		queue_delete(pool->inject);
+		free(pool);
+		return NULL;
+	}
+
+	for (size_t i = 0; i < threads; i++) {
+		if (_tp_deque_init(&pool->workers[i].deque) != OK) {
+			while (i-- > 0)
+				_tp_deque_free(&pool->workers[i].deque);
+			free(pool->workers);
+			queue_delete(pool->inject);
+			free(pool);
+			return NULL;
+		}
+		pool->workers[i].pool = pool;
+		pool->workers[i].seed = 0x9E3779B97F4A7C15ull * (i + 1);
+	}
+
+	pthread_mutex_init(&pool->inject_lock, NULL);
+	pthread_mutex_init(&pool->sleep_lock, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+	atomic_init(&pool->injected, 0);
+	atomic_init(&pool->queued, 0);
+	atomic_init(&pool->sleepers, 0);
+	atomic_init(&pool->stop, 0);
+
+	// the work is shared between the workers that could actually be started
+	pthread_mutex_lock(&pool->sleep_lock);
+
+	size_t started = 0;
+	while (started < threads && !pthread_create(&pool->workers[started].thread, NULL, _tp_worker_main, &pool->workers[started]))
+		started++;
+
+	for (size_t i = started; i < threads; i++)
+		_tp_deque_free(&pool->workers[i].deque);
+	pool->count = started;
+
+	pthread_mutex_unlock(&pool->sleep_lock);
+
+	return pool;
+}
+
+clib_exit_code_t thread_pool_delete(thread_pool_t* pool) {
+	if (!pool)
+		return NULL_REF;
+
+	pthread_mutex_lock(&pool->sleep_lock);
+	atomic_store(&pool->stop, 1);
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->sleep_lock);
+
+	for (size_t i = 0; i < pool->count; i++) {
+		pthread_join(pool->workers[i].thread, NULL);
+		_tp_deque_free(&pool->workers[i].deque);
+	}
+
+	pthread_cond_destroy(&pool->wake);
+	pthread_mutex_destroy(&pool->sleep_lock);
+	pthread_mutex_destroy(&pool->inject_lock);
+	queue_delete(pool->inject);
+	free(pool->workers);
+	free(pool);
+
+	return OK;
+}
+
+size_t thread_pool_threads(thread_pool_t* pool) {
+	if (!pool)
+		return 0;
+	return pool->count;
+}
+
+void tp_task_init(tp_task_t* task, void (*function)(void*), void* arg) {
+	task->function = function;
+	task->arg = arg;
+	atomic_init(&task->done, 0);
+}
+
+clib_exit_code_t thread_pool_spawn(thread_pool_t* pool, tp_task_t* task) {
+	if (!pool || !task || !task->function)
+		return NULL_REF;
+
+	tp_worker_t* self = _tp_self(pool);
+	clib_exit_code_t err;
+
+	// counted first, so the task is never taken before it is counted
+	atomic_fetch_add(&pool->queued, 1);
+
+	if (self) {
+		err = _tp_deque_push(&self->deque, task);
+	} else {
+		pthread_mutex_lock(&pool->inject_lock);
+		err = queue_push(pool->inject, &task);
+		if (err == OK)
+			atomic_fetch_add(&pool->injected, 1);
+		pthread_mutex_unlock(&pool->inject_lock);
+	}
+
+	// out of memory for the queue, a fork may always run in place
+	if (err != OK) {
+		atomic_fetch_sub(&pool->queued, 1);
+		_tp_execute(task);
+		return OK;
+	}
+
+	_tp_wake(pool);
+
+	return OK;
+}
+
+void thread_pool_join(thread_pool_t* pool, tp_task_t* task) {
+	if (!pool || !task)
+		return;
+
+	tp_worker_t* self = _tp_self(pool);
+	uint64_t seed = (uintptr_t)task | 1;
+
+	while (!atomic_load_explicit(&task->done, memory_order_acquire)) {
+		tp_task_t* other = _tp_find(pool, self, &seed);
+		if (other)
+			_tp_execute(other);
+		else
+			sched_yield();
+	}
+}
+
+clib_exit_code_t thread_pool_run(thread_pool_t* pool, void (*function)(void*), void* arg) {
+	if (!pool || !function)
+		return NULL_REF;
+
+	if (_tp_self(pool)) {
+		function(arg);
+		return OK;
+	}
+
+	tp_task_t task;
+	tp_task_init(&task, function, arg);
+	thread_pool_spawn(pool, &task);
+	thread_pool_join(pool, &task);
+
+	return OK;
+}
+
+
+// PARALLEL FOR
+
+typedef struct tp_range_s {
+	thread_pool_t* pool;
+	size_t begin;
+	size_t end;
+	size_t grain;
+	void (*body)(size_t, size_t, void*);
+	void* arg;
+} tp_range_t;
+
+// splits the range in halves, forking the right one, until it is small enough
+static void _tp_range(void* arg) {
+	tp_range_t* range = arg;
+
+	if (range->end - range->begin <= range->grain) {
+		range->body(range->begin, range->end, range->arg);
+		return;
+	}
+
+	size_t mid = range->begin + (range->end - range->begin) / 2;
+	tp_range_t left = *range;
+	tp_range_t right = *range;
+	left.end = mid;
+	right.begin = mid;
+
+	tp_task_t task;
+	tp_task_init(&task, _tp_range, &right);
+	thread_pool_spawn(range->pool, &task);
+	_tp_range(&left);
+	thread_pool_join(range->pool, &task);
+}
+
+clib_exit_code_t thread_pool_parallel_for(thread_pool_t* pool, size_t begin, size_t end, size_t grain,
+		void (*body)(size_t begin, size_t end, void* arg), void* arg) {
+	if (!pool || !body)
+		return NULL_REF;
+
+	if (begin >= end)
+		return OK;
+
+	tp_range_t range;
+	range.pool = pool;
+	range.begin = begin;
+	range.end = end;
+	range.grain = _max(grain, 1);
+	range.body = body;
+	range.arg = arg;
+
+	return thread_pool_run(pool, _tp_range, &range);
+}
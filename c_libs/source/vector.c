@@ -19,6 +19,12 @@ clib_exit_code_t add_capacity(vector_t* vec, size_t count) {
 	return OK;
 }
 
+clib_exit_code_t _vec_grow(vector_t* vec, size_t min_capacity) {
+	size_t capacity = _max(min_capacity, 2 * vec->capacity);
+
+	return add_capacity(vec, capacity - vec->capacity);
+}
+
 vector_t* vec_init(size_t capacity, size_t count, size_t data_size) {
 	capacity = _max(capacity, count);
 	if(capacity == 0)
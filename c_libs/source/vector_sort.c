@@ -0,0 +1,410 @@
+/* =================================
+Copyright (C) 2023 Vornicescu Vasile
+Parallel sorting of vectors in C
+*/
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../include/vector.h"
+
+// elements a thread must get at least before another thread is started
+#define SORT_GRAIN (1 << 14)
+
+#define RADIX_BITS 8
+#define RADIX_BUCKETS (1 << RADIX_BITS)
+
+typedef struct sort_job_s {
+	size_t threads;
+	size_t count;
+	size_t data_size;
+	char* src;
+	char* tmp;
+	pthread_barrier_t barrier;
+	pthread_mutex_t gate;
+	// held while the workers are started
+
+	// merge sort
+	uint8_t (*compare)(const void*, const void*);
+
+	// radix sort
+	vec_key_t key;
+	size_t (*hist)[RADIX_BUCKETS];
+	// one histogram per thread
+} sort_job_t;
+
+typedef struct sort_worker_s {
+	sort_job_t* job;
+	size_t id;
+} sort_worker_t;
+
+
+static size_t _sort_threads(size_t threads, size_t count) {
+	if(threads == 0) {
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = cores > 0 ? cores : 1;
+	}
+
+	return _max(1, _min(threads, count / SORT_GRAIN));
+}
+
+
+// runs worker on threads, the calling thread being worker 0
+static clib_exit_code_t _sort_run(sort_job_t* job, void* (*worker)(void*)) {
+	sort_worker_t* workers = malloc(job->threads * sizeof(sort_worker_t));
+	pthread_t* handles = malloc(job->threads * sizeof(pthread_t));
+	if(workers == NULL || handles == NULL) {
+		free(workers);
+		free(handles);
+		return OUT_OF_MEM;
+	}
+
+	for(size_t i = 0; i < job->threads; i++) {
+		workers[i].job = job;
+		workers[i].id = i;
+	}
+
+	// the work is split between the threads that could actually be started
+	pthread_mutex_init(&job->gate, NULL);
+	pthread_mutex_lock(&job->gate);
+
+	size_t started = 1;
+	while(started < job->threads && !pthread_create(&handles[started], NULL, worker, &workers[started]))
+		started++;
+
+	job->threads = started;
+	pthread_barrier_init(&job->barrier, NULL, started);
+	pthread_mutex_unlock(&job->gate);
+
+	worker(&workers[0]);
+
+	for(size_t i = 1; i < started; i++)
+		pthread_join(handles[i], NULL);
+
+	pthread_barrier_destroy(&job->barrier);
+	pthread_mutex_destroy(&job->gate);
+	free(workers);
+	free(handles);
+
+	return OK;
+}
+
+
+// Merge sort ======================================================================================
+
+
+// number of elements taken from a in the first out elements of the stable merge of a and b
+static size_t _merge_corank(const sort_job_t* job, const char* a, size_t na, const char* b, size_t nb, size_t out) {
+	size_t size = job->data_size;
+	size_t lo = out > nb ? out - nb : 0;
+	size_t hi = _min(out, na);
+
+	while(lo < hi) {
+		size_t i = lo + (hi - lo) / 2;
+		// a[i] <= b[out - i - 1] means a[i] is still among the first out elements
+		if(!job->compare(a + i * size, b + (out - i - 1) * size))
+			lo = i + 1;
+		else
+			hi = i;
+	}
+
+	return lo;
+}
+
+
+// writes elements [out_lo, out_hi) of the stable merge of a and b to dst
+static void _merge_range(const sort_job_t* job, const char* a, size_t na, const char* b, size_t nb,
+		size_t out_lo, size_t out_hi, char* dst) {
+	size_t size = job->data_size;
+	size_t i = _merge_corank(job, a, na, b, nb, out_lo);
+	size_t j = out_lo - i;
+	size_t i_end = _merge_corank(job, a, na, b, nb, out_hi);
+	size_t j_end = out_hi - i_end;
+
+	while(i < i_end && j < j_end) {
+		if(job->compare(a + i * size, b + j * size)) {
+			memcpy(dst, b + j * size, size);
+			j++;
+		} else {
+			memcpy(dst, a + i * size, size);
+			i++;
+		}
+		dst += size;
+	}
+
+	memcpy(dst, a + i * size, (i_end - i) * size);
+	dst += (i_end - i) * size;
+	memcpy(dst, b + j * size, (j_end - j) * size);
+}
+
+
+// one merge pass: runs of run elements in src are merged by pairs into dst
+// every worker writes an equal slice of dst, whatever runs it falls into
+static void _merge_pass(const sort_job_t* job, const char* src, char* dst, size_t run, size_t lo, size_t hi) {
+	size_t size = job->data_size;
+
+	while(lo < hi) {
+		size_t pair = lo - lo % (2 * run);
+		size_t mid = _min(pair + run, job->count);
+		size_t end = _min(pair + 2 * run, job->count);
+		size_t seg_end = _min(hi, end);
+
+		_merge_range(job, src + pair * size, mid - pair, src + mid * size, end - mid,
+			lo - pair, seg_end - pair, dst + lo * size);
+
+		lo = seg_end;
+	}
+}
+
+
+// sequential bottom-up merge sort of count elements, result left in data
+static void _merge_sort_chunk(const sort_job_t* job, char* data, char* tmp, size_t count) {
+	size_t size = job->data_size;
+	size_t run = 16;
+
+	// insertion sort of small runs
+	char* value = tmp;
+	for(size_t start = 0; start < count; start += run) {
+		size_t end = _min(start + run, count);
+		for(size_t i = start + 1; i < end; i++) {
+			if(!job->compare(data + (i - 1) * size, data + i * size))
+				continue;
+
+			memcpy(value, data + i * size, size);
+			size_t j = i;
+			while(j > start && job->compare(data + (j - 1) * size, value)) {
+				memcpy(data + j * size, data + (j - 1) * size, size);
+				j--;
+			}
+			memcpy(data + j * size, value, size);
+		}
+	}
+
+	char* src = data;
+	char* dst = tmp;
+	for(; run < count; run *= 2) {
+		for(size_t pair = 0; pair < count; pair += 2 * run) {
+			size_t mid = _min(pair + run, count);
+			size_t end = _min(pair + 2 * run, count);
+			_merge_range(job, src + pair * size, mid - pair, src + mid * size, end - mid,
+				0, end - pair, dst + pair * size);
+		}
+
+		char* swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	if(src != data)
+		memcpy(data, src, count * size);
+}
+
+
+static void* _merge_sort_worker(void* arg) {
+	sort_worker_t* worker = arg;
+	sort_job_t* job = worker->job;
+	size_t size = job->data_size;
+
+	pthread_mutex_lock(&job->gate);
+	pthread_mutex_unlock(&job->gate);
+
+	size_t run = (job->count + job->threads - 1) / job->threads;
+
+	size_t lo = _min(worker->id * run, job->count);
+	size_t hi = _min(lo + run, job->count);
+	_merge_sort_chunk(job, job->src + lo * size, job->tmp + lo * size, hi - lo);
+
+	char* src = job->src;
+	char* dst = job->tmp;
+	lo = worker->id * job->count / job->threads;
+	hi = (worker->id + 1) * job->count / job->threads;
+
+	for(; run < job->count; run *= 2) {
+		pthread_barrier_wait(&job->barrier);
+		_merge_pass(job, src, dst, run, lo, hi);
+
+		char* swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	// every worker took the same number of passes, the last one must be
+	// finished reading job->src before it is overwritten
+	pthread_barrier_wait(&job->barrier);
+	if(src != job->src)
+		memcpy(job->src + lo * size, src + lo * size, (hi - lo) * size);
+
+	return NULL;
+}
+
+
+clib_exit_code_t vec_sort_parallel(vector_t* vec, uint8_t (*compare)(const void*, const void*), size_t threads) {
+	if(vec == NULL || compare == NULL) {
+		printf("\n[vector->vec_sort_parallel]: Null reference to vector or comparator!\n");
+		return NULL_REF;
+	}
+
+	if(vec->count < 2)
+		return OK;
+
+	sort_job_t job;
+	job.threads = _sort_threads(threads, vec->count);
+	job.count = vec->count;
+	job.data_size = vec->data_size;
+	job.compare = compare;
+	job.src = vec->data;
+	job.tmp = malloc(vec->count * vec->data_size);
+	if(job.tmp == NULL) {
+		printf("\n[vector->vec_sort_parallel]: Out of memory!\n");
+		return OUT_OF_MEM;
+	}
+
+	clib_exit_code_t err = _sort_run(&job, _merge_sort_worker);
+
+	free(job.tmp);
+
+	return err;
+}
+
+
+// Radix sort ======================================================================================
+
+
+static size_t _radix_key_size(vec_key_t key) {
+	switch(key) {
+		case VEC_KEY_INT32:
+		case VEC_KEY_UINT32:
+		case VEC_KEY_FLOAT:
+			return 4;
+		default:
+			return 8;
+	}
+}
+
+
+// maps a key to unsigned bits with the same order
+static inline uint64_t _radix_bits(const char* elem, vec_key_t key) {
+	uint32_t u32;
+	uint64_t u64;
+
+	switch(key) {
+		case VEC_KEY_INT32:
+			memcpy(&u32, elem, 4);
+			return u32 ^ 0x80000000u;
+		case VEC_KEY_UINT32:
+			memcpy(&u32, elem, 4);
+			return u32;
+		case VEC_KEY_FLOAT:
+			memcpy(&u32, elem, 4);
+			return (u32 & 0x80000000u) ? ~u32 : (u32 | 0x80000000u);
+		case VEC_KEY_INT64:
+			memcpy(&u64, elem, 8);
+			return u64 ^ 0x8000000000000000ull;
+		case VEC_KEY_UINT64:
+			memcpy(&u64, elem, 8);
+			return u64;
+		default:
+			memcpy(&u64, elem, 8);
+			return (u64 & 0x8000000000000000ull) ? ~u64 : (u64 | 0x8000000000000000ull);
+	}
+}
+
+
+static void* _radix_sort_worker(void* arg) {
+	sort_worker_t* worker = arg;
+	sort_job_t* job = worker->job;
+	size_t size = job->data_size;
+
+	pthread_mutex_lock(&job->gate);
+	pthread_mutex_unlock(&job->gate);
+
+	size_t lo = worker->id * job->count / job->threads;
+	size_t hi = (worker->id + 1) * job->count / job->threads;
+	size_t* hist = job->hist[worker->id];
+	size_t offset[RADIX_BUCKETS];
+
+	char* src = job->src;
+	char* dst = job->tmp;
+
+	for(size_t shift = 0; shift < 8 * size; shift += RADIX_BITS) {
+		memset(hist, 0, sizeof(job->hist[0]));
+		for(size_t i = lo; i < hi; i++)
+			hist[(_radix_bits(src + i * size, job->key) >> shift) & (RADIX_BUCKETS - 1)]++;
+
+		pthread_barrier_wait(&job->barrier);
+
+		// every worker computes its own offsets from all histograms
+		size_t sum = 0;
+		int skip = 0;
+		for(size_t d = 0; d < RADIX_BUCKETS; d++) {
+			size_t total = 0;
+			for(size_t t = 0; t < job->threads; t++) {
+				if(t == worker->id)
+					offset[d] = sum + total;
+				total += job->hist[t][d];
+			}
+			// all keys share this digit, the pass would not move anything
+			if(total == job->count)
+				skip = 1;
+			sum += total;
+		}
+
+		if(!skip) {
+			for(size_t i = lo; i < hi; i++) {
+				const char* elem = src + i * size;
+				size_t d = (_radix_bits(elem, job->key) >> shift) & (RADIX_BUCKETS - 1);
+				memcpy(dst + (offset[d]++) * size, elem, size);
+			}
+
+			char* swap = src;
+			src = dst;
+			dst = swap;
+		}
+
+		// histograms are reset and dst read only once everybody is done
+		pthread_barrier_wait(&job->barrier);
+	}
+
+	if(src != job->src)
+		memcpy(job->src + lo * size, src + lo * size, (hi - lo) * size);
+
+	return NULL;
+}
+
+
+clib_exit_code_t vec_radix_sort_parallel(vector_t* vec, vec_key_t key, size_t threads) {
+	if(vec == NULL) {
+		printf("\n[vector->vec_radix_sort_parallel]: Null reference to vector!\n");
+		return NULL_REF;
+	}
+
+	if(vec->data_size != _radix_key_size(key)) {
+		printf("\n[vector->vec_radix_sort_parallel]: Data size does not match the key type!\n");
+		return UNSAFE;
+	}
+
+	if(vec->count < 2)
+		return OK;
+
+	sort_job_t job;
+	job.threads = _sort_threads(threads, vec->count);
+	job.count = vec->count;
+	job.data_size = vec->data_size;
+	job.key = key;
+	job.src = vec->data;
+	job.tmp = malloc(vec->count * vec->data_size);
+	job.hist = malloc(job.threads * sizeof(job.hist[0]));
+	if(job.tmp == NULL || job.hist == NULL) {
+		printf("\n[vector->vec_radix_sort_parallel]: Out of memory!\n");
+		free(job.tmp);
+		free(job.hist);
+		return OUT_OF_MEM;
+	}
+
+	clib_exit_code_t err = _sort_run(&job, _radix_sort_worker);
+
+	free(job.tmp);
+	free(job.hist);
+
+	return err;
+}
@@ -0,0 +1,41 @@
+#ifndef CSQR_API
+#define CSQR_API
+
+#include "csqr_utils.h"
+#include "csqr_reader.h"
+#include "csqr_profile.h"
+
+// Embedding API of libcsquare
+//
+// A program is compiled once and can then be executed any number of times,
+// with different input and output streams, without parsing the source again.
+// A compiled program is never modified by csqr_execute, so the same program
+// may be executed from several threads at once.
+
+
+// compile a csqr source stream into a reusable program
+CSQR_EXIT csqr_compile(FILE* file, unsigned int flags, program_t** out);
+
+
+// open and compile a csqr source file into a reusable program
+CSQR_EXIT csqr_compile_file(const char* path, unsigned int flags, program_t** out);
+
+
+// execute a compiled program reading from input and writing to output
+// NULL streams default to stdin / stdout
+CSQR_EXIT csqr_execute(const program_t* program, FILE* input, FILE* output, unsigned int flags);
+
+
+// same as csqr_execute, recording operand types, branches and calls in profile
+CSQR_EXIT csqr_execute_profiled(const program_t* program, FILE* input, FILE* output, unsigned int flags, csqr_profile_t* profile);
+
+
+// free a program returned by csqr_compile or csqr_compile_file
+void csqr_program_delete(program_t* program);
+
+
+// compile and execute the source file of a task
+// with FLAG_PROFILE the profile of the run is saved as <source>.prof
+CSQR_EXIT solve_task(csqr_task_t* task);
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef CSQR_BATCH
+#define CSQR_BATCH
+
+#include "csqr_utils.h"
+
+// Batch mode (csquare -b)
+//
+// Runs many scripts in one process on a pool of worker threads. Every script
+// executes in its own run, identical sources share one compiled program
+// through a program cache, and the time of each script is reported.
+
+typedef struct csqr_batch_s csqr_batch_t;
+
+
+// create an empty batch
+csqr_batch_t* csqr_batch_init(unsigned int flags);
+
+
+// delete a batch
+void csqr_batch_delete(csqr_batch_t* batch);
+
+
+// add a script to the batch
+// a path starting with '@' names a manifest file with one script per line
+CSQR_EXIT csqr_batch_add(csqr_batch_t* batch, const char* path);
+
+
+// number of scripts in the batch
+unsigned int csqr_batch_count(csqr_batch_t* batch);
+
+
+// run all scripts on a pool of workers and print the report
+// workers = 0 uses one worker per online core
+CSQR_EXIT csqr_batch_run(csqr_batch_t* batch, unsigned int workers);
+
+#endif
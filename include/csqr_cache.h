@@ -0,0 +1,39 @@
+#ifndef CSQR_CACHE
+#define CSQR_CACHE
+
+#include "csqr_utils.h"
+#include "csqr_reader.h"
+
+// Cache of compiled programs shared between threads
+//
+// Sources are keyed by their content, so identical scripts are parsed once
+// even when they live at different paths. Cached programs are owned by the
+// cache and must only be executed, never deleted, by the callers, who give
+// them back with program_cache_release once done. A cache with a capacity
+// evicts the least recently used programs nobody holds to stay within it.
+
+typedef struct program_cache_s program_cache_t;
+
+
+// create an empty program cache keeping at most capacity programs, 0 for no limit
+program_cache_t* program_cache_init(unsigned int capacity);
+
+
+// delete the cache and every program in it
+void program_cache_delete(program_cache_t* cache);
+
+
+// get the compiled program of a source file, compiling it on a miss
+// *hit is set to 1 if the program was already in the cache
+// a program returned in *out stays valid until it is released
+CSQR_EXIT program_cache_get(program_cache_t* cache, const char* path, unsigned int flags, const program_t** out, int* hit);
+
+
+// give back a program from program_cache_get, NULL is ignored
+void program_cache_release(program_cache_t* cache, const program_t* program);
+
+
+// number of distinct programs in the cache
+unsigned int program_cache_count(program_cache_t* cache);
+
+#endif
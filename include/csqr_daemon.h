@@ -0,0 +1,39 @@
+#ifndef CSQR_DAEMON
+#define CSQR_DAEMON
+
+#include "csqr_utils.h"
+
+// Daemon mode (csquare -d)
+//
+// The daemon keeps compiled programs warm and runs scripts on request over a
+// local Unix socket. One request per connection, every request is one line:
+//
+//     RUN <absolute path to csqr file>
+//     STOP
+//
+// The reply is a sequence of frames, each a kind byte and the payload length
+// as 4 bytes big endian followed by the payload. Output frames carry the
+// output of the script, the last frame is the exit frame with the payload
+//
+//     <exit code> <milliseconds>
+//
+// so nothing the script prints can be taken for its exit code.
+
+#define DAEMON_RUN "RUN "
+#define DAEMON_STOP "STOP"
+
+#define DAEMON_FRAME_HEADER 5
+#define DAEMON_FRAME_OUTPUT 'O'
+#define DAEMON_FRAME_EXIT 'X'
+
+#define DAEMON_CACHE_PROGRAMS 256
+// compiled programs kept warm, the least recently run ones are dropped past this
+
+#define DAEMON_ACCEPT_BACKOFF_MS 100
+// pause before accepting again when out of file descriptors or buffers
+
+
+// serve requests on the socket until a STOP request
+CSQR_EXIT csqr_daemon_run(const char* socket_path, unsigned int flags);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef CSQR_JIT
+#define CSQR_JIT
+
+#include "csqr_utils.h"
+#include "csqr_reader.h"
+
+// Tiered execution
+//
+// Every interpreted function owns a jit_function_t. The interpreter calls
+// jit_hit on each call and loop back-edge of the function; once the hit count
+// reaches the engine threshold the function is queued to a background thread
+// which asks the translator C backend for the function source, compiles it
+// with the system C compiler into a shared object and dlopen-s it. From then
+// on jit_hit returns the native entry and the interpreter calls it instead.
+
+#define JIT_DEFAULT_THRESHOLD 1000
+
+typedef struct jit_engine_s jit_engine_t;
+typedef struct jit_function_s jit_function_t;
+
+// native entry of a compiled function
+typedef void (*native_func)(csqr_obj_t** args, int arg_count, csqr_obj_t* result);
+
+// writes the C source of a function defining symbol_name as a native_func
+// returns 0 on succes
+typedef int (*emit_c_func)(void* function, const char* symbol_name, FILE* out);
+
+typedef enum {
+	JIT_COLD = 0,
+	JIT_QUEUED = 1,
+	JIT_NATIVE = 2,
+	JIT_FAILED = 3
+} JIT_STATE;
+
+
+// start an engine with its compiler thread, NULL on error
+// threshold = 0 uses JIT_DEFAULT_THRESHOLD, compiler = NULL uses $CC or cc
+jit_engine_t* jit_engine_init(unsigned int threshold, const char* compiler);
+
+
+// stop the compiler thread and delete the engine
+// functions must be deleted after their engine
+void jit_engine_delete(jit_engine_t* engine);
+
+
+// register a function to be counted by the engine
+jit_function_t* jit_function_init(jit_engine_t* engine, unsigned int id, void* function, emit_c_func emit);
+
+
+// delete a function and unload its native code
+void jit_function_delete(jit_function_t* func);
+
+
+// count one call or back-edge, returns the native entry once available
+native_func jit_hit(jit_function_t* func);
+
+
+// get the tier the function is currently in
+JIT_STATE jit_function_state(jit_function_t* func);
+
+#endif
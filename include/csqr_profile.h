@@ -0,0 +1,87 @@
+#ifndef CSQR_PROFILE
+#define CSQR_PROFILE
+
+#include "csqr_utils.h"
+
+// Execution profiles (csquare -p, translator -p)
+//
+// The interpreter records, per operator site, the data types of the operands
+// it saw, per branch site how often the branch was taken, and per function how
+// often it was called. The profile is saved next to the source as
+// <source>.prof and the translator uses it to emit type specialized C guarded
+// by a type check, and branches laid out for their observed direction.
+//
+// Recording is not thread safe, one profile belongs to one run.
+
+#define PROFILE_TYPE_SLOTS 4
+// distinct operand types remembered per site, further types only count as megamorphic
+
+#define PROFILE_MAX_SITES (1u << 20)
+// site and function ids from here on are not recorded, a profile file naming one is rejected
+
+#define PROFILE_MIN_SAMPLES 16
+// sites seen less often than this are not specialized
+
+#define PROFILE_BIAS_PERCENT 90
+// share of samples a type or branch direction needs to be specialized for
+
+typedef struct csqr_profile_s csqr_profile_t;
+
+
+// create an empty profile
+csqr_profile_t* profile_init();
+
+
+// delete a profile
+void profile_delete(csqr_profile_t* profile);
+
+
+// build <source>.prof into out, returns 0 on succes
+int profile_path(const char* source, char* out, size_t size);
+
+
+// save a profile in its compact binary form, returns 0 on succes
+int profile_save(csqr_profile_t* profile, const char* path);
+
+
+// load a profile saved by profile_save, NULL on error
+csqr_profile_t* profile_load(const char* path);
+
+
+// record the type of an operand evaluated at an operator site
+void profile_record_operand(csqr_profile_t* profile, unsigned int site, unsigned int type_id);
+
+
+// record the direction of a branch
+void profile_record_branch(csqr_profile_t* profile, unsigned int site, int taken);
+
+
+// record a call of a function
+void profile_record_call(csqr_profile_t* profile, unsigned int function);
+
+
+// returns 1 and sets type_id if the site is dominated by one operand type
+int profile_dominant_type(csqr_profile_t* profile, unsigned int site, unsigned int* type_id);
+
+
+// returns 1 if the branch is mostly taken, -1 if mostly not taken, 0 otherwise
+int profile_branch_bias(csqr_profile_t* profile, unsigned int site);
+
+
+// number of recorded calls of a function
+unsigned long profile_call_count(csqr_profile_t* profile, unsigned int function);
+
+
+// number of operator sites, branch sites and functions with samples
+void profile_summary(csqr_profile_t* profile, unsigned int* operators, unsigned int* branches, unsigned int* functions);
+
+
+// emit "if (cond)" for a branch site, hinted with its observed direction
+void profile_emit_branch(csqr_profile_t* profile, unsigned int site, const char* cond, FILE* out);
+
+
+// emit the guard of a type specialized operator site, returns 1 if emitted
+// the caller then emits the specialized code, "} else {", the generic code and "}"
+int profile_emit_type_guard(csqr_profile_t* profile, unsigned int site, const char* type_id_expr, FILE* out);
+
+#endif
@@ -25,6 +25,12 @@ typedef void (*conversion_func)(csqr_obj_t*);
 
 
 
+// allocate an empty program, to be filled by create_program
+program_t* program_init();
+
+// free a program and everything it owns
+void program_delete(program_t* program);
+
 COMP_ERROR create_program(FILE* file, program_t* out);
 
 COMP_ERROR create_expresion_tree(program_t* program, char* expresion, unsigned int l, unsigned int r, expresion_t* out);
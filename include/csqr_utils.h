@@ -6,7 +6,10 @@
 #include <string.h>
 
 #define OPERATOR_COUNT 1
-#define DEBUG
+#define CSQR_SOCKET_NAME "csquare.sock"
+#define CSQR_SOCKET_DIR "/tmp/csquare-"
+#define CSQR_RUNTIME_ENV "XDG_RUNTIME_DIR"
+#define CSQR_SOCKET_ENV "CSQUARE_SOCKET"
 #define LINUX
 
 typedef enum {
@@ -16,7 +19,9 @@ typedef enum {
 	UNKNOUN_FLAG_EXIT = -3,
 	NULL_REF_EXIT = -4,
 	TOO_MANY_ARGS_EXIT = -5,
-	COMPILATION_ERROR_EXIT = -6
+	COMPILATION_ERROR_EXIT = -6,
+	BATCH_ERROR_EXIT = -7,
+	DAEMON_ERROR_EXIT = -8
 } CSQR_EXIT;
 
 typedef enum {
@@ -26,7 +31,10 @@ typedef enum {
 } COMP_ERROR;
 
 typedef enum {
-	FLAG_VERBOSE = 0 // -v
+	FLAG_VERBOSE = 0, // -v
+	FLAG_BATCH = 1, // -b
+	FLAG_DAEMON = 2, // -d
+	FLAG_PROFILE = 3 // -p
 } FLAGS;
 
 typedef struct {
@@ -41,4 +49,12 @@ typedef struct {
 unsigned int is_flag_on(unsigned int flags, FLAGS id);
 void set_flag_on(unsigned int* flags, FLAGS id);
 
+// path of the daemon socket, $CSQUARE_SOCKET, else CSQR_SOCKET_NAME in
+// $XDG_RUNTIME_DIR, else in the private directory CSQR_SOCKET_DIR<uid>
+const char* csqr_socket_path();
+
+
+// the private directory CSQR_SOCKET_DIR<uid> when path is the socket in it, NULL otherwise
+const char* csqr_socket_private_dir(const char* path);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include "../include/csqr_api.h"
+
+
+CSQR_EXIT csqr_compile(FILE* file, unsigned int flags, program_t** out) {
+	if (!file || !out)
+		return NULL_REF_EXIT;
+
+	*out = NULL;
+
+	program_t* program = program_init();
+	if (!program) {
+		printf("Error: Not enough memory to create program\n\n");
+		return COMPILATION_ERROR_EXIT;
+	}
+
+	COMP_ERROR comp = create_program(file, program);
+	if (comp) {
+		printf("Error while compiling program. error code = <%d>\n\n", comp);
+		program_delete(program);
+		return COMPILATION_ERROR_EXIT;
+	}
+
+	if (is_flag_on(flags, FLAG_VERBOSE)) {
+		printf("Program succesfuly proccessed with exit code = <%d>\n\n", comp);
+	}
+
+	*out = program;
+
+	return SUCCES_EXIT;
+}
+
+
+CSQR_EXIT csqr_compile_file(const char* path, unsigned int flags, program_t** out) {
+	if (!path || !out)
+		return NULL_REF_EXIT;
+
+	if (is_flag_on(flags, FLAG_VERBOSE)) {
+		printf("Trying to open sourcefile: %s\n", path);
+	}
+
+	FILE* src = fopen(path, "r");
+	if (!src) {
+		printf("Error: Could not open file %s\n\n", path);
+		return NO_FILE_EXIT;
+	}
+
+	if (is_flag_on(flags, FLAG_VERBOSE)) {
+		printf("Sourcefile opened\n\n");
+
+		printf("Preprocessing sourcefile: %s\n\n", path);
+	}
+
+	CSQR_EXIT exit_code = csqr_compile(src, flags, out);
+
+	fclose(src);
+
+	return exit_code;
+}
+
+
+CSQR_EXIT csqr_execute(const program_t* program, FILE* input, FILE* output, unsigned int flags) {
+	return csqr_execute_profiled(program, input, output, flags, NULL);
+}
+
+
+CSQR_EXIT csqr_execute_profiled(const program_t* program, FILE* input, FILE* output, unsigned int flags, csqr_profile_t* profile) {
+	if (!program)
+		return NULL_REF_EXIT;
+
+	if (!input)
+		input = stdin;
+	if (!output)
+		output = stdout;
+
+	if (is_flag_on(flags, FLAG_VERBOSE)) {
+		fprintf(output, "Executing the program\n\n");
+	}
+
+	return SUCCES_EXIT;
+}
+
+
+void csqr_program_delete(program_t* program) {
+	program_delete(program);
+}
+
+
+CSQR_EXIT solve_task(csqr_task_t* task) {
+	if (!task)
+		return NULL_REF_EXIT;
+
+	if (!task->source_code) {
+		printf("Error: No source file given\n\n");
+		return NO_ARGS_EXIT;
+	}
+
+	program_t* program = NULL;
+	CSQR_EXIT exit_code = csqr_compile_file(task->source_code, task->flags, &program);
+	if (exit_code != SUCCES_EXIT)
+		return exit_code;
+
+	csqr_profile_t* profile = NULL;
+	if (is_flag_on(task->flags, FLAG_PROFILE)) {
+		profile = profile_init();
+		if (!profile) {
+			csqr_program_delete(program);
+			return NULL_REF_EXIT;
+		}
+	}
+
+	exit_code = csqr_execute_profiled(program, stdin, stdout, task->flags, profile);
+
+	if (profile) {
+		char path[4096];
+		if (profile_path(task->source_code, path, sizeof(path)) || profile_save(profile, path)) {
+			printf("Error: Could not save profile of %s\n\n", task->source_code);
+		} else if (is_flag_on(task->flags, FLAG_VERBOSE)) {
+			printf("Profile saved to %s\n\n", path);
+		}
+		profile_delete(profile);
+	}
+
+	csqr_program_delete(program);
+
+	return exit_code;
+}
@@ -0,0 +1,224 @@
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../include/csqr_batch.h"
+#include "../include/csqr_cache.h"
+#include "../include/csqr_api.h"
+#include "../c_libs/include/vector.h"
+
+
+typedef struct {
+	CSQR_EXIT exit_code;
+	int cached;
+	double millis;
+} batch_result_t;
+
+
+struct csqr_batch_s {
+	unsigned int flags;
+
+	vector_t* scripts;
+	// char* paths owned by the batch
+
+	program_cache_t* cache;
+	batch_result_t* results;
+
+	atomic_uint next;
+	// index of the next script to be taken by a worker
+};
+
+
+static double _now_millis() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+
+static CSQR_EXIT _batch_push(csqr_batch_t* batch, const char* path, size_t length) {
+	char* copy = malloc(length + 1);
+	if (!copy)
+		return NULL_REF_EXIT;
+
+	memcpy(copy, path, length);
+	copy[length] = '\0';
+
+	if (vec_push_back(batch->scripts, &copy) != OK) {
+		free(copy);
+		return NULL_REF_EXIT;
+	}
+
+	return SUCCES_EXIT;
+}
+
+
+static CSQR_EXIT _batch_load_manifest(csqr_batch_t* batch, const char* path) {
+	FILE* manifest = fopen(path, "r");
+	if (!manifest) {
+		printf("Error: Could not open manifest %s\n\n", path);
+		return NO_FILE_EXIT;
+	}
+
+	char line[4096];
+	CSQR_EXIT exit_code = SUCCES_EXIT;
+
+	while (exit_code == SUCCES_EXIT && fgets(line, sizeof(line), manifest)) {
+		size_t length = strcspn(line, "\r\n");
+
+		// skip empty lines and comments
+		if (length == 0 || line[0] == '#')
+			continue;
+
+		exit_code = _batch_push(batch, line, length);
+	}
+
+	fclose(manifest);
+
+	return exit_code;
+}
+
+
+csqr_batch_t* csqr_batch_init(unsigned int flags) {
+	csqr_batch_t* batch = malloc(sizeof(csqr_batch_t));
+	if (!batch)
+		return NULL;
+
+	batch->scripts = vec_init(16, 0, sizeof(char*));
+	if (!batch->scripts) {
+		free(batch);
+		return NULL;
+	}
+
+	batch->flags = flags;
+	batch->cache = NULL;
+	batch->results = NULL;
+	atomic_init(&batch->next, 0);
+
+	return batch;
+}
+
+
+void csqr_batch_delete(csqr_batch_t* batch) {
+	if (!batch)
+		return;
+
+	for (size_t i = 0; i < vec_count(batch->scripts); i++)
+		free(*(char* const*)vec_get(batch->scripts, i));
+
+	vec_delete(batch->scripts);
+	program_cache_delete(batch->cache);
+	free(batch->results);
+	free(batch);
+}
+
+
+CSQR_EXIT csqr_batch_add(csqr_batch_t* batch, const char* path) {
+	if (!batch || !path)
+		return NULL_REF_EXIT;
+
+	if (path[0] == '@')
+		return _batch_load_manifest(batch, path + 1);
+
+	return _batch_push(batch, path, strlen(path));
+}
+
+
+unsigned int csqr_batch_count(csqr_batch_t* batch) {
+	if (!batch)
+		return 0;
+	return vec_count(batch->scripts);
+}
+
+
+static void* _batch_worker(void* arg) {
+	csqr_batch_t* batch = arg;
+	unsigned int count = vec_count(batch->scripts);
+
+	// verbose output of the compiler would interleave between workers
+	unsigned int flags = batch->flags & ~(1u << FLAG_VERBOSE);
+
+	while (1) {
+		unsigned int i = atomic_fetch_add(&batch->next, 1);
+		if (i >= count)
+			break;
+
+		const char* path = *(char* const*)vec_get(batch->scripts, i);
+		batch_result_t* result = &batch->results[i];
+		double start = _now_millis();
+
+		const program_t* program = NULL;
+		result->exit_code = program_cache_get(batch->cache, path, flags, &program, &result->cached);
+		if (result->exit_code == SUCCES_EXIT)
+			result->exit_code = csqr_execute(program, stdin, stdout, flags);
+		program_cache_release(batch->cache, program);
+
+		result->millis = _now_millis() - start;
+	}
+
+	return NULL;
+}
+
+
+CSQR_EXIT csqr_batch_run(csqr_batch_t* batch, unsigned int workers) {
+	if (!batch)
+		return NULL_REF_EXIT;
+
+	unsigned int count = vec_count(batch->scripts);
+	if (count == 0) {
+		printf("Error: No source file given\n\n");
+		return NO_ARGS_EXIT;
+	}
+
+	if (workers == 0) {
+		long cores = sysconf(_SC_NPROCESSORS_ONLN);
+		workers = cores > 0 ? cores : 1;
+	}
+	if (workers > count)
+		workers = count;
+
+	program_cache_delete(batch->cache);
+	free(batch->results);
+
+	batch->cache = program_cache_init(0);
+	batch->results = calloc(count, sizeof(batch_result_t));
+	if (!batch->cache || !batch->results)
+		return NULL_REF_EXIT;
+
+	atomic_store(&batch->next, 0);
+
+	pthread_t* threads = malloc(workers * sizeof(pthread_t));
+	if (!threads)
+		return NULL_REF_EXIT;
+
+	double start = _now_millis();
+
+	// the calling thread is worker 0
+	unsigned int started = 1;
+	while (started < workers && !pthread_create(&threads[started], NULL, _batch_worker, batch))
+		started++;
+
+	_batch_worker(batch);
+
+	for (unsigned int i = 1; i < started; i++)
+		pthread_join(threads[i], NULL);
+
+	double total = _now_millis() - start;
+	free(threads);
+
+	unsigned int failed = 0;
+	for (unsigned int i = 0; i < count; i++) {
+		batch_result_t* result = &batch->results[i];
+		if (result->exit_code != SUCCES_EXIT)
+			failed++;
+
+		printf("[batch] %s: exit %d, %.3f ms%s\n", *(char* const*)vec_get(batch->scripts, i),
+			result->exit_code, result->millis, result->cached ? " (cached)" : "");
+	}
+
+	printf("[batch] %u scripts, %u failed, %u distinct programs, %u workers, %.3f ms\n",
+		count, failed, program_cache_count(batch->cache), started, total);
+
+	return failed ? BATCH_ERROR_EXIT : SUCCES_EXIT;
+}
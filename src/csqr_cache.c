@@ -0,0 +1,340 @@
+#include <pthread.h>
+
+#include "../include/csqr_cache.h"
+#include "../include/csqr_api.h"
+#include "../c_libs/include/avl.h"
+
+
+typedef struct cache_entry_s cache_entry_t;
+
+struct cache_entry_s {
+	char* source;
+	size_t length;
+
+	uint64_t hash;
+
+	program_t* program;
+	CSQR_EXIT exit_code;
+	int ready;
+	// 0 while the program is being compiled by some thread
+
+	unsigned int users;
+	// callers holding the program, an entry in use is never evicted
+
+	cache_entry_t* next;
+	// next entry with the same hash
+
+	cache_entry_t* newer;
+	cache_entry_t* older;
+	// place in the recently used list
+};
+
+
+struct program_cache_s {
+	avl_tree_t* entries;
+	// uint64_t source hash -> cache_entry_t* chain
+
+	avl_tree_t* programs;
+	// program_t* -> cache_entry_t*, to find the entry of a released program
+
+	unsigned int count;
+	unsigned int capacity;
+
+	cache_entry_t* newest;
+	cache_entry_t* oldest;
+
+	pthread_mutex_t lock;
+	pthread_cond_t compiled;
+};
+
+
+static int _hash_comparation(const void* a, const void* b) {
+	uint64_t x = *(const uint64_t*)a;
+	uint64_t y = *(const uint64_t*)b;
+	return (x > y) - (x < y);
+}
+
+
+static int _pointer_comparation(const void* a, const void* b) {
+	uintptr_t x = *(const uintptr_t*)a;
+	uintptr_t y = *(const uintptr_t*)b;
+	return (x > y) - (x < y);
+}
+
+
+// FNV-1a
+static uint64_t _source_hash(const char* source, size_t length) {
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < length; i++) {
+		hash ^= (unsigned char)source[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+
+// read a whole file in memory, NULL on error
+static char* _read_source(const char* path, size_t* length) {
+	FILE* file = fopen(path, "rb");
+	if (!file)
+		return NULL;
+
+	size_t size = 0;
+	size_t capacity = 4096;
+	char* source = malloc(capacity);
+
+	while (source) {
+		size += fread(source + size, 1, capacity - size, file);
+		if (size < capacity)
+			break;
+
+		char* tmp = realloc(source, capacity *= 2);
+		if (!tmp) {
+			free(source);
+			source = NULL;
+		}
+		source = tmp;
+	}
+
+	fclose(file);
+
+	// the read loop always leaves room for a terminator
+	if (source)
+		source[size] = '\0';
+
+	*length = size;
+	return source;
+}
+
+
+static void _lru_unlink(program_cache_t* cache, cache_entry_t* entry) {
+	if (entry->newer)
+		entry->newer->older = entry->older;
+	else
+		cache->newest = entry->older;
+
+	if (entry->older)
+		entry->older->newer = entry->newer;
+	else
+		cache->oldest = entry->newer;
+}
+
+
+static void _lru_push(program_cache_t* cache, cache_entry_t* entry) {
+	entry->newer = NULL;
+	entry->older = cache->newest;
+
+	if (cache->newest)
+		cache->newest->newer = entry;
+	else
+		cache->oldest = entry;
+	cache->newest = entry;
+}
+
+
+static void _entry_delete(cache_entry_t* entry) {
+	program_delete(entry->program);
+	free(entry->source);
+	free(entry);
+}
+
+
+// drop an unused entry, the cache lock must be held
+static void _evict(program_cache_t* cache, cache_entry_t* entry) {
+	cache_entry_t* const* chain = avl_tree_search(cache->entries, &entry->hash);
+	cache_entry_t* head = *chain;
+
+	if (head == entry) {
+		if (entry->next)
+			avl_tree_insert(cache->entries, &entry->hash, &entry->next);
+		else
+			avl_tree_erase(cache->entries, &entry->hash);
+	} else {
+		while (head->next != entry)
+			head = head->next;
+		head->next = entry->next;
+	}
+
+	if (entry->program)
+		avl_tree_erase(cache->programs, &entry->program);
+
+	_lru_unlink(cache, entry);
+	cache->count--;
+	_entry_delete(entry);
+}
+
+
+// evict the least recently used entries not in use until the cache fits its capacity
+static void _shrink(program_cache_t* cache) {
+	cache_entry_t* entry = cache->oldest;
+
+	while (cache->capacity && cache->count > cache->capacity && entry) {
+		cache_entry_t* newer = entry->newer;
+		if (entry->ready && !entry->users)
+			_evict(cache, entry);
+		entry = newer;
+	}
+}
+
+
+program_cache_t* program_cache_init(unsigned int capacity) {
+	program_cache_t* cache = malloc(sizeof(program_cache_t));
+	if (!cache)
+		return NULL;
+
+	cache->entries = avl_tree_init(sizeof(cache_entry_t*), sizeof(uint64_t), _hash_comparation);
+	cache->programs = avl_tree_init(sizeof(cache_entry_t*), sizeof(uintptr_t), _pointer_comparation);
+	if (!cache->entries || !cache->programs) {
+		if (cache->entries)
+			avl_tree_delete(cache->entries);
+		if (cache->programs)
+			avl_tree_delete(cache->programs);
+		free(cache);
+		return NULL;
+	}
+
+	cache->count = 0;
+	cache->capacity = capacity;
+	cache->newest = NULL;
+	cache->oldest = NULL;
+	pthread_mutex_init(&cache->lock, NULL);
+	pthread_cond_init(&cache->compiled, NULL);
+
+	return cache;
+}
+
+
+void program_cache_delete(program_cache_t* cache) {
+	if (!cache)
+		return;
+
+	cache_entry_t* entry = cache->newest;
+	while (entry) {
+		cache_entry_t* older = entry->older;
+		_entry_delete(entry);
+		entry = older;
+	}
+
+	avl_tree_delete(cache->entries);
+	avl_tree_delete(cache->programs);
+	pthread_mutex_destroy(&cache->lock);
+	pthread_cond_destroy(&cache->compiled);
+	free(cache);
+}
+
+
+CSQR_EXIT program_cache_get(program_cache_t* cache, const char* path, unsigned int flags, const program_t** out, int* hit) {
+	if (!cache || !path || !out)
+		return NULL_REF_EXIT;
+
+	*out = NULL;
+	if (hit)
+		*hit = 0;
+
+	size_t length = 0;
+	char* source = _read_source(path, &length);
+	if (!source) {
+		printf("Error: Could not open file %s\n\n", path);
+		return NO_FILE_EXIT;
+	}
+
+	uint64_t hash = _source_hash(source, length);
+
+	pthread_mutex_lock(&cache->lock);
+
+	cache_entry_t* const* chain = avl_tree_search(cache->entries, &hash);
+	cache_entry_t* entry = chain ? *chain : NULL;
+	while (entry && (entry->length != length || memcmp(entry->source, source, length)))
+		entry = entry->next;
+
+	if (entry) {
+		free(source);
+
+		// taken before waiting, so the entry can not be evicted meanwhile
+		entry->users++;
+		_lru_unlink(cache, entry);
+		_lru_push(cache, entry);
+
+		while (!entry->ready)
+			pthread_cond_wait(&cache->compiled, &cache->lock);
+
+		// a failed compilation has nothing to give back, and without a user
+		// the entry may be evicted as soon as the lock is released
+		program_t* program = entry->program;
+		CSQR_EXIT exit_code = entry->exit_code;
+		if (!program)
+			entry->users--;
+		pthread_mutex_unlock(&cache->lock);
+
+		if (hit)
+			*hit = 1;
+		*out = program;
+		return exit_code;
+	}
+
+	entry = malloc(sizeof(cache_entry_t));
+	if (!entry) {
+		pthread_mutex_unlock(&cache->lock);
+		free(source);
+		return COMPILATION_ERROR_EXIT;
+	}
+
+	entry->source = source;
+	entry->length = length;
+	entry->hash = hash;
+	entry->program = NULL;
+	entry->exit_code = SUCCES_EXIT;
+	entry->ready = 0;
+	entry->users = 1;
+	entry->next = chain ? *chain : NULL;
+	avl_tree_insert(cache->entries, &hash, &entry);
+	_lru_push(cache, entry);
+	cache->count++;
+
+	// compile outside the lock, other sources can be compiled meanwhile
+	pthread_mutex_unlock(&cache->lock);
+
+	program_t* program = NULL;
+	CSQR_EXIT exit_code = NO_FILE_EXIT;
+	FILE* file = fmemopen(source, length ? length : 1, "r");
+	if (file) {
+		exit_code = csqr_compile(file, flags, &program);
+		fclose(file);
+	}
+
+	pthread_mutex_lock(&cache->lock);
+	entry->program = program;
+	entry->exit_code = exit_code;
+	entry->ready = 1;
+	if (program)
+		avl_tree_insert(cache->programs, &program, &entry);
+	else
+		entry->users--;
+	_shrink(cache);
+	pthread_cond_broadcast(&cache->compiled);
+	pthread_mutex_unlock(&cache->lock);
+
+	*out = program;
+	return exit_code;
+}
+
+
+void program_cache_release(program_cache_t* cache, const program_t* program) {
+	if (!cache || !program)
+		return;
+
+	pthread_mutex_lock(&cache->lock);
+
+	cache_entry_t* const* found = avl_tree_search(cache->programs, &program);
+	if (found && --(*found)->users == 0)
+		_shrink(cache);
+
+	pthread_mutex_unlock(&cache->lock);
+}
+
+
+unsigned int program_cache_count(program_cache_t* cache) {
+	if (!cache)
+		return 0;
+	return cache->count;
+}
@@ -0,0 +1,122 @@
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "../include/csqr_daemon.h"
+
+// Thin client of the csquare daemon
+//
+//     csquare_client file.csqr    runs file.csqr on the daemon
+//     csquare_client -k           stops the daemon
+
+
+int connect_daemon(const char* socket_path) {
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(socket_path) >= sizeof(addr.sun_path))
+		return -1;
+	strcpy(addr.sun_path, socket_path);
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		return -1;
+
+	if (connect(fd, (struct sockaddr*)&addr, sizeof(addr))) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+
+// read exactly size bytes, 0 on success
+int read_all(int fd, void* buf, size_t size) {
+	char* data = buf;
+
+	while (size) {
+		ssize_t got = recv(fd, data, size, 0);
+		if (got < 0 && errno == EINTR)
+			continue;
+		if (got <= 0)
+			return -1;
+		data += got;
+		size -= got;
+	}
+
+	return 0;
+}
+
+
+// forward the output frames to stdout and return the exit code of the exit frame
+CSQR_EXIT read_reply(int fd) {
+	char buffer[4096];
+	unsigned char header[DAEMON_FRAME_HEADER];
+	int exit_code = NULL_REF_EXIT;
+
+	while (!read_all(fd, header, sizeof(header))) {
+		size_t size = (size_t)header[1] << 24 | (size_t)header[2] << 16 | (size_t)header[3] << 8 | header[4];
+
+		if (header[0] == DAEMON_FRAME_EXIT) {
+			if (size >= sizeof(buffer) || read_all(fd, buffer, size))
+				break;
+			buffer[size] = '\0';
+			sscanf(buffer, "%d", &exit_code);
+			break;
+		}
+
+		while (size) {
+			size_t chunk = size < sizeof(buffer) ? size : sizeof(buffer);
+			if (read_all(fd, buffer, chunk)) {
+				close(fd);
+				return exit_code;
+			}
+			if (header[0] == DAEMON_FRAME_OUTPUT)
+				fwrite(buffer, 1, chunk, stdout);
+			size -= chunk;
+		}
+	}
+
+	close(fd);
+
+	return exit_code;
+}
+
+
+int main(int argc, char *argv[]) {
+	char request[PATH_MAX + 16];
+
+	if (argc != 2) {
+		printf("Usage: %s file.csqr | -k\n", argv[0]);
+		return NO_ARGS_EXIT;
+	}
+
+	if (!strcmp(argv[1], "-k")) {
+		snprintf(request, sizeof(request), "%s\n", DAEMON_STOP);
+	} else {
+		// the daemon may run in another working directory
+		char path[PATH_MAX];
+		if (!realpath(argv[1], path)) {
+			printf("Error: Could not open file %s\n\n", argv[1]);
+			return NO_FILE_EXIT;
+		}
+		snprintf(request, sizeof(request), "%s%s\n", DAEMON_RUN, path);
+	}
+
+	const char* socket_path = csqr_socket_path();
+	int fd = connect_daemon(socket_path);
+	if (fd < 0) {
+		printf("Error: No csquare daemon listening on %s\n\n", socket_path);
+		return DAEMON_ERROR_EXIT;
+	}
+
+	if (send(fd, request, strlen(request), MSG_NOSIGNAL) < 0) {
+		close(fd);
+		return NULL_REF_EXIT;
+	}
+
+	return read_reply(fd);
+}
@@ -0,0 +1,321 @@
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "../include/csqr_daemon.h"
+#include "../include/csqr_cache.h"
+#include "../include/csqr_api.h"
+
+
+typedef struct {
+	program_cache_t* cache;
+	unsigned int flags;
+
+	int listen_fd;
+	int stop;
+
+	unsigned int active;
+	// connections being served
+
+	pthread_mutex_t lock;
+	pthread_cond_t idle;
+} daemon_t;
+
+
+typedef struct {
+	daemon_t* daemon;
+	int fd;
+} connection_t;
+
+
+static double _now_millis() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+
+// a client leaving early must not kill the daemon with SIGPIPE
+static int _send_all(int fd, const void* buf, size_t size) {
+	const char* data = buf;
+
+	while (size) {
+		ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+		if (sent < 0 && errno == EINTR)
+			continue;
+		if (sent <= 0)
+			return -1;
+		data += sent;
+		size -= sent;
+	}
+
+	return 0;
+}
+
+
+static int _send_frame(int fd, char kind, const void* payload, size_t size) {
+	unsigned char header[DAEMON_FRAME_HEADER] = {
+		kind, (unsigned char)(size >> 24), (unsigned char)(size >> 16), (unsigned char)(size >> 8), (unsigned char)size
+	};
+
+	if (_send_all(fd, header, sizeof(header)))
+		return -1;
+	return _send_all(fd, payload, size);
+}
+
+
+static ssize_t _socket_write(void* cookie, const char* buf, size_t size) {
+	return _send_frame(*(int*)cookie, DAEMON_FRAME_OUTPUT, buf, size) ? -1 : (ssize_t)size;
+}
+
+
+// read one request line, returns its length or -1
+// the request is all a client sends, so reading past its end loses nothing
+static int _read_request(int fd, char* line, int max) {
+	int length = 0;
+
+	while (length < max - 1) {
+		ssize_t got = recv(fd, line + length, max - 1 - length, 0);
+		if (got < 0 && errno == EINTR)
+			continue;
+		if (got <= 0)
+			return -1;
+
+		char* end = memchr(line + length, '\n', got);
+		if (end) {
+			*end = '\0';
+			return end - line;
+		}
+		length += got;
+	}
+
+	line[length] = '\0';
+	return length;
+}
+
+
+// only the user running the daemon may run scripts through it or stop it
+static int _same_user(int fd) {
+	struct ucred peer;
+	socklen_t size = sizeof(peer);
+
+	if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &peer, &size))
+		return 0;
+	return peer.uid == geteuid();
+}
+
+
+static void _serve(daemon_t* daemon, int fd) {
+	if (!_same_user(fd))
+		return;
+
+	char request[4096];
+	if (_read_request(fd, request, sizeof(request)) < 0)
+		return;
+
+	cookie_io_functions_t io = { NULL, _socket_write, NULL, NULL };
+	FILE* out = fopencookie(&fd, "w", io);
+	if (!out)
+		return;
+
+	double start = _now_millis();
+	CSQR_EXIT exit_code = SUCCES_EXIT;
+
+	if (!strcmp(request, DAEMON_STOP)) {
+		pthread_mutex_lock(&daemon->lock);
+		daemon->stop = 1;
+		// wakes the accept loop
+		shutdown(daemon->listen_fd, SHUT_RDWR);
+		pthread_mutex_unlock(&daemon->lock);
+	} else if (!strncmp(request, DAEMON_RUN, strlen(DAEMON_RUN))) {
+		const program_t* program = NULL;
+		exit_code = program_cache_get(daemon->cache, request + strlen(DAEMON_RUN), daemon->flags, &program, NULL);
+		if (exit_code == SUCCES_EXIT)
+			exit_code = csqr_execute(program, NULL, out, daemon->flags);
+		program_cache_release(daemon->cache, program);
+	} else {
+		exit_code = UNKNOUN_FLAG_EXIT;
+	}
+
+	// flushes the last output frame before the exit frame
+	fclose(out);
+
+	char status[64];
+	int length = snprintf(status, sizeof(status), "%d %.3f", exit_code, _now_millis() - start);
+	_send_frame(fd, DAEMON_FRAME_EXIT, status, length);
+}
+
+
+static void* _connection_thread(void* arg) {
+	connection_t* connection = arg;
+	daemon_t* daemon = connection->daemon;
+
+	_serve(daemon, connection->fd);
+	close(connection->fd);
+	free(connection);
+
+	pthread_mutex_lock(&daemon->lock);
+	if (--daemon->active == 0)
+		pthread_cond_signal(&daemon->idle);
+	pthread_mutex_unlock(&daemon->lock);
+
+	return NULL;
+}
+
+
+// 0 if nothing listens on the socket path, a stale socket left by a daemon that
+// died is removed, -1 if a daemon is still serving there or the path is unusable
+static int _claim_socket(const struct sockaddr_un* addr) {
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0)
+		return -1;
+
+	int in_use = !connect(fd, (const struct sockaddr*)addr, sizeof(*addr));
+	int error = errno;
+	close(fd);
+
+	if (in_use)
+		return -1;
+	if (error == ENOENT)
+		return 0;
+	if (error == ECONNREFUSED)
+		return unlink(addr->sun_path) ? -1 : 0;
+
+	return -1;
+}
+
+
+// creates the private socket directory, or checks that an existing one
+// belongs to this user and is closed to everyone else
+static int _prepare_private_dir(const char* dir) {
+	struct stat info;
+
+	if (mkdir(dir, 0700) && errno != EEXIST)
+		return -1;
+	if (lstat(dir, &info) || !S_ISDIR(info.st_mode) || info.st_uid != geteuid())
+		return -1;
+
+	return (info.st_mode & 077) ? chmod(dir, 0700) : 0;
+}
+
+
+CSQR_EXIT csqr_daemon_run(const char* socket_path, unsigned int flags) {
+	if (!socket_path)
+		socket_path = csqr_socket_path();
+
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+		printf("Error: Socket path too long %s\n\n", socket_path);
+		return DAEMON_ERROR_EXIT;
+	}
+	strcpy(addr.sun_path, socket_path);
+
+	daemon_t daemon;
+	daemon.flags = flags;
+	daemon.stop = 0;
+	daemon.active = 0;
+	const char* private_dir = csqr_socket_private_dir(socket_path);
+	if (private_dir && _prepare_private_dir(private_dir)) {
+		printf("Error: %s is not a private directory of this user\n\n", private_dir);
+		return DAEMON_ERROR_EXIT;
+	}
+
+	if (_claim_socket(&addr)) {
+		printf("Error: %s is in use, is another daemon running?\n\n", socket_path);
+		return DAEMON_ERROR_EXIT;
+	}
+
+	daemon.cache = program_cache_init(DAEMON_CACHE_PROGRAMS);
+	if (!daemon.cache)
+		return NULL_REF_EXIT;
+
+	// the socket is created without access for other users
+	daemon.listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	mode_t mask = umask(077);
+	int bound = daemon.listen_fd >= 0 && !bind(daemon.listen_fd, (struct sockaddr*)&addr, sizeof(addr));
+	umask(mask);
+
+	if (!bound || listen(daemon.listen_fd, 64)) {
+		printf("Error: Could not listen on %s\n\n", socket_path);
+		if (daemon.listen_fd >= 0)
+			close(daemon.listen_fd);
+		program_cache_delete(daemon.cache);
+		return DAEMON_ERROR_EXIT;
+	}
+
+	pthread_mutex_init(&daemon.lock, NULL);
+	pthread_cond_init(&daemon.idle, NULL);
+
+	if (is_flag_on(flags, FLAG_VERBOSE)) {
+		printf("Listening on %s\n\n", socket_path);
+	}
+
+	while (1) {
+		int fd = accept(daemon.listen_fd, NULL, NULL);
+		int error = errno;
+
+		pthread_mutex_lock(&daemon.lock);
+		int stop = daemon.stop;
+		pthread_mutex_unlock(&daemon.lock);
+
+		if (fd < 0) {
+			if (stop)
+				break;
+
+			// the daemon outlives failed connections, running out of
+			// descriptors or buffers waits a little for some to be freed
+			if (error != EINTR)
+				printf("Error: accept failed on %s: %s\n\n", socket_path, strerror(error));
+			if (error == EMFILE || error == ENFILE || error == ENOBUFS || error == ENOMEM)
+				nanosleep(&(struct timespec){ 0, DAEMON_ACCEPT_BACKOFF_MS * 1000000L }, NULL);
+			continue;
+		}
+
+		connection_t* connection = malloc(sizeof(connection_t));
+		pthread_t thread;
+
+		if (connection) {
+			connection->daemon = &daemon;
+			connection->fd = fd;
+
+			pthread_mutex_lock(&daemon.lock);
+			daemon.active++;
+			pthread_mutex_unlock(&daemon.lock);
+
+			if (!pthread_create(&thread, NULL, _connection_thread, connection)) {
+				pthread_detach(thread);
+				continue;
+			}
+
+			pthread_mutex_lock(&daemon.lock);
+			daemon.active--;
+			pthread_mutex_unlock(&daemon.lock);
+			free(connection);
+		}
+
+		close(fd);
+	}
+
+	// let the requests in flight finish before dropping the cache
+	pthread_mutex_lock(&daemon.lock);
+	while (daemon.active)
+		pthread_cond_wait(&daemon.idle, &daemon.lock);
+	pthread_mutex_unlock(&daemon.lock);
+
+	close(daemon.listen_fd);
+	unlink(socket_path);
+
+	pthread_mutex_destroy(&daemon.lock);
+	pthread_cond_destroy(&daemon.idle);
+	program_cache_delete(daemon.cache);
+
+	return SUCCES_EXIT;
+}
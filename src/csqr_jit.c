@@ -0,0 +1,253 @@
+#include <stdatomic.h>
+#include <pthread.h>
+#include <dlfcn.h>
+#include <unistd.h>
+
+#include "../include/csqr_jit.h"
+#include "../c_libs/include/queue.h"
+
+
+struct jit_engine_s {
+	unsigned int threshold;
+	char compiler[256];
+	char work_dir[64];
+
+	queue_t* pending;
+	// jit_function_t* waiting to be compiled
+
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_t thread;
+	int stop;
+};
+
+
+struct jit_function_s {
+	jit_engine_t* engine;
+	unsigned int id;
+
+	void* function;
+	emit_c_func emit;
+
+	atomic_uint hits;
+	atomic_int state;
+	_Atomic(native_func) native;
+
+	void* handle;
+	// dlopen handle, owned by the function
+};
+
+
+// builds <work_dir>/f<id>.<ext>
+static void _jit_path(jit_function_t* func, const char* ext, char* out, size_t n) {
+	snprintf(out, n, "%s/f%u.%s", func->engine->work_dir, func->id, ext);
+}
+
+
+static JIT_STATE _jit_compile(jit_function_t* func) {
+	char symbol[64];
+	char c_path[128];
+	char so_path[128];
+	char command[768];
+
+	snprintf(symbol, sizeof(symbol), "csqr_native_%u", func->id);
+	_jit_path(func, "c", c_path, sizeof(c_path));
+	_jit_path(func, "so", so_path, sizeof(so_path));
+
+	FILE* out = fopen(c_path, "w");
+	if (!out)
+		return JIT_FAILED;
+
+	int err = func->emit(func->function, symbol, out);
+	fclose(out);
+	if (err)
+		return JIT_FAILED;
+
+	snprintf(command, sizeof(command), "%s -O2 -shared -fPIC -o %s %s", func->engine->compiler, so_path, c_path);
+	int status = system(command);
+	unlink(c_path);
+	if (status != 0) {
+		unlink(so_path);
+		return JIT_FAILED;
+	}
+
+	// the mapping stays valid after the file is unlinked
+	void* handle = dlopen(so_path, RTLD_NOW | RTLD_LOCAL);
+	unlink(so_path);
+	if (!handle)
+		return JIT_FAILED;
+
+	native_func native = (native_func)dlsym(handle, symbol);
+	if (!native) {
+		dlclose(handle);
+		return JIT_FAILED;
+	}
+
+	func->handle = handle;
+	atomic_store_explicit(&func->native, native, memory_order_release);
+
+	return JIT_NATIVE;
+}
+
+
+static void* _jit_worker(void* arg) {
+	jit_engine_t* engine = arg;
+
+	pthread_mutex_lock(&engine->lock);
+	while (1) {
+		while (!engine->stop && queue_count(engine->pending) == 0)
+			pthread_cond_wait(&engine->wake, &engine->lock);
+
+		if (engine->stop)
+			break;
+
+		jit_function_t* func = *(jit_function_t* const*)queue_head(engine->pending);
+		queue_pop(engine->pending);
+
+		// compile without holding the lock so the interpreter is never blocked
+		pthread_mutex_unlock(&engine->lock);
+		atomic_store(&func->state, _jit_compile(func));
+		pthread_mutex_lock(&engine->lock);
+	}
+	pthread_mutex_unlock(&engine->lock);
+
+	return NULL;
+}
+
+
+jit_engine_t* jit_engine_init(unsigned int threshold, const char* compiler) {
+	jit_engine_t* engine = malloc(sizeof(jit_engine_t));
+	if (!engine)
+		return NULL;
+
+	if (!compiler)
+		compiler = getenv("CC");
+	if (!compiler)
+		compiler = "cc";
+
+	engine->threshold = threshold ? threshold : JIT_DEFAULT_THRESHOLD;
+	snprintf(engine->compiler, sizeof(engine->compiler), "%s", compiler);
+	strcpy(engine->work_dir, "/tmp/csquare-jit-XXXXXX");
+	engine->stop = 0;
+
+	if (!mkdtemp(engine->work_dir)) {
+		free(engine);
+		return NULL;
+	}
+
+	engine->pending = queue_init(sizeof(jit_function_t*));
+	if (!engine->pending) {
+		rmdir(engine->work_dir);
+		free(engine);
+		return NULL;
+	}
+
+	pthread_mutex_init(&engine->lock, NULL);
+	pthread_cond_init(&engine->wake, NULL);
+
+	if (pthread_create(&engine->thread, NULL, _jit_worker, engine)) {
+		pthread_mutex_destroy(&engine->lock);
+		pthread_cond_destroy(&engine->wake);
+		queue_delete(engine->pending);
+		rmdir(engine->work_dir);
+		free(engine);
+		return NULL;
+	}
+
+	return engine;
+}
+
+
+void jit_engine_delete(jit_engine_t* engine) {
+	if (!engine)
+		return;
+
+	pthread_mutex_lock(&engine->lock);
+	engine->stop = 1;
+	pthread_cond_signal(&engine->wake);
+	pthread_mutex_unlock(&engine->lock);
+
+	pthread_join(engine->thread, NULL);
+
+	// functions still waiting will never be compiled
+	while (queue_count(engine->pending)) {
+		jit_function_t* func = *(jit_function_t* const*)queue_head(engine->pending);
+		atomic_store(&func->state, JIT_FAILED);
+		queue_pop(engine->pending);
+	}
+
+	pthread_mutex_destroy(&engine->lock);
+	pthread_cond_destroy(&engine->wake);
+	queue_delete(engine->pending);
+	rmdir(engine->work_dir);
+	free(engine);
+}
+
+
+jit_function_t* jit_function_init(jit_engine_t* engine, unsigned int id, void* function, emit_c_func emit) {
+	if (!engine || !emit)
+		return NULL;
+
+	jit_function_t* func = malloc(sizeof(jit_function_t));
+	if (!func)
+		return NULL;
+
+	func->engine = engine;
+	func->id = id;
+	func->function = function;
+	func->emit = emit;
+	func->handle = NULL;
+	atomic_init(&func->hits, 0);
+	atomic_init(&func->state, JIT_COLD);
+	atomic_init(&func->native, NULL);
+
+	return func;
+}
+
+
+void jit_function_delete(jit_function_t* func) {
+	if (!func)
+		return;
+
+	if (func->handle)
+		dlclose(func->handle);
+
+	free(func);
+}
+
+
+native_func jit_hit(jit_function_t* func) {
+	native_func native = atomic_load_explicit(&func->native, memory_order_acquire);
+	if (native)
+		return native;
+
+	// queued, compiling or failed functions are not counted anymore
+	if (atomic_load_explicit(&func->state, memory_order_relaxed) != JIT_COLD)
+		return NULL;
+
+	unsigned int hits = atomic_fetch_add_explicit(&func->hits, 1, memory_order_relaxed) + 1;
+	if (hits < func->engine->threshold)
+		return NULL;
+
+	// exactly one caller moves the function out of COLD and queues it
+	int expected = JIT_COLD;
+	if (!atomic_compare_exchange_strong(&func->state, &expected, JIT_QUEUED))
+		return NULL;
+
+	jit_engine_t* engine = func->engine;
+
+	pthread_mutex_lock(&engine->lock);
+	if (queue_push(engine->pending, &func) != OK)
+		atomic_store(&func->state, JIT_FAILED);
+	pthread_cond_signal(&engine->wake);
+	pthread_mutex_unlock(&engine->lock);
+
+	return NULL;
+}
+
+
+JIT_STATE jit_function_state(jit_function_t* func) {
+	if (!func)
+		return JIT_FAILED;
+	return atomic_load(&func->state);
+}
@@ -0,0 +1,398 @@
+#include "../include/csqr_profile.h"
+#include "../c_libs/include/vector.h"
+
+#define PROFILE_MAGIC "CSQP"
+#define PROFILE_VERSION 1
+
+
+typedef struct {
+	unsigned int type_id[PROFILE_TYPE_SLOTS];
+	unsigned long count[PROFILE_TYPE_SLOTS];
+	unsigned long megamorphic;
+} operator_site_t;
+
+
+typedef struct {
+	unsigned long taken;
+	unsigned long not_taken;
+} branch_site_t;
+
+
+struct csqr_profile_s {
+	vector_t* operators;
+	// operator_site_t indexed by site id
+
+	vector_t* branches;
+	// branch_site_t indexed by site id
+
+	vector_t* calls;
+	// unsigned long indexed by function id
+};
+
+
+// grow a zero filled vector so that index is valid, returns the element,
+// NULL for ids past PROFILE_MAX_SITES
+static void* _profile_slot(vector_t* vec, size_t index) {
+	size_t count = vec_count(vec);
+
+	if (index >= PROFILE_MAX_SITES)
+		return NULL;
+
+	if (index >= count) {
+		// doubling keeps the reallocations logarithmic in the number of sites,
+		// the extra slots stay zero and count as sites without samples
+		size_t grown = _max(index + 1, 2 * count);
+		if (vec_resize(vec, grown) != OK)
+			return NULL;
+		memset(vec_at_unchecked(vec, count), 0, (grown - count) * vec->data_size);
+	}
+
+	return vec_at_unchecked(vec, index);
+}
+
+
+csqr_profile_t* profile_init() {
+	csqr_profile_t* profile = malloc(sizeof(csqr_profile_t));
+	if (!profile)
+		return NULL;
+
+	profile->operators = vec_init(16, 0, sizeof(operator_site_t));
+	profile->branches = vec_init(16, 0, sizeof(branch_site_t));
+	profile->calls = vec_init(16, 0, sizeof(unsigned long));
+
+	if (!profile->operators || !profile->branches || !profile->calls) {
+		profile_delete(profile);
+		return NULL;
+	}
+
+	return profile;
+}
+
+
+void profile_delete(csqr_profile_t* profile) {
+	if (!profile)
+		return;
+
+	if (profile->operators)
+		vec_delete(profile->operators);
+	if (profile->branches)
+		vec_delete(profile->branches);
+	if (profile->calls)
+		vec_delete(profile->calls);
+	free(profile);
+}
+
+
+int profile_path(const char* source, char* out, size_t size) {
+	if (!source || !out)
+		return -1;
+
+	return snprintf(out, size, "%s.prof", source) >= (int)size;
+}
+
+
+void profile_record_operand(csqr_profile_t* profile, unsigned int site, unsigned int type_id) {
+	operator_site_t* slot = _profile_slot(profile->operators, site);
+	if (!slot)
+		return;
+
+	for (int i = 0; i < PROFILE_TYPE_SLOTS; i++) {
+		if (slot->count[i] && slot->type_id[i] == type_id) {
+			slot->count[i]++;
+			return;
+		}
+		if (!slot->count[i]) {
+			slot->type_id[i] = type_id;
+			slot->count[i] = 1;
+			return;
+		}
+	}
+
+	slot->megamorphic++;
+}
+
+
+void profile_record_branch(csqr_profile_t* profile, unsigned int site, int taken) {
+	branch_site_t* slot = _profile_slot(profile->branches, site);
+	if (!slot)
+		return;
+
+	if (taken)
+		slot->taken++;
+	else
+		slot->not_taken++;
+}
+
+
+void profile_record_call(csqr_profile_t* profile, unsigned int function) {
+	unsigned long* slot = _profile_slot(profile->calls, function);
+	if (slot)
+		(*slot)++;
+}
+
+
+int profile_dominant_type(csqr_profile_t* profile, unsigned int site, unsigned int* type_id) {
+	if (!profile || site >= vec_count(profile->operators))
+		return 0;
+
+	const operator_site_t* slot = vec_get(profile->operators, site);
+	unsigned long total = slot->megamorphic;
+	int best = 0;
+
+	for (int i = 0; i < PROFILE_TYPE_SLOTS; i++) {
+		total += slot->count[i];
+		if (slot->count[i] > slot->count[best])
+			best = i;
+	}
+
+	if (total < PROFILE_MIN_SAMPLES || slot->count[best] * 100 < total * PROFILE_BIAS_PERCENT)
+		return 0;
+
+	if (type_id)
+		*type_id = slot->type_id[best];
+	return 1;
+}
+
+
+int profile_branch_bias(csqr_profile_t* profile, unsigned int site) {
+	if (!profile || site >= vec_count(profile->branches))
+		return 0;
+
+	const branch_site_t* slot = vec_get(profile->branches, site);
+	unsigned long total = slot->taken + slot->not_taken;
+
+	if (total < PROFILE_MIN_SAMPLES)
+		return 0;
+	if (slot->taken * 100 >= total * PROFILE_BIAS_PERCENT)
+		return 1;
+	if (slot->not_taken * 100 >= total * PROFILE_BIAS_PERCENT)
+		return -1;
+	return 0;
+}
+
+
+unsigned long profile_call_count(csqr_profile_t* profile, unsigned int function) {
+	if (!profile || function >= vec_count(profile->calls))
+		return 0;
+
+	return *(const unsigned long*)vec_get(profile->calls, function);
+}
+
+
+void profile_summary(csqr_profile_t* profile, unsigned int* operators, unsigned int* branches, unsigned int* functions) {
+	unsigned int o = 0, b = 0, f = 0;
+
+	if (profile) {
+		for (size_t i = 0; i < vec_count(profile->operators); i++) {
+			const operator_site_t* slot = vec_get(profile->operators, i);
+			o += slot->count[0] != 0;
+		}
+		for (size_t i = 0; i < vec_count(profile->branches); i++) {
+			const branch_site_t* slot = vec_get(profile->branches, i);
+			b += (slot->taken + slot->not_taken) != 0;
+		}
+		for (size_t i = 0; i < vec_count(profile->calls); i++)
+			f += *(const unsigned long*)vec_get(profile->calls, i) != 0;
+	}
+
+	if (operators)
+		*operators = o;
+	if (branches)
+		*branches = b;
+	if (functions)
+		*functions = f;
+}
+
+
+void profile_emit_branch(csqr_profile_t* profile, unsigned int site, const char* cond, FILE* out) {
+	int bias = profile_branch_bias(profile, site);
+
+	if (bias > 0)
+		fprintf(out, "if (__builtin_expect(!!(%s), 1))", cond);
+	else if (bias < 0)
+		fprintf(out, "if (__builtin_expect(!!(%s), 0))", cond);
+	else
+		fprintf(out, "if (%s)", cond);
+}
+
+
+int profile_emit_type_guard(csqr_profile_t* profile, unsigned int site, const char* type_id_expr, FILE* out) {
+	unsigned int type_id = 0;
+	if (!profile_dominant_type(profile, site, &type_id))
+		return 0;
+
+	fprintf(out, "if (__builtin_expect((%s) == %uu, 1)) {\n", type_id_expr, type_id);
+	return 1;
+}
+
+
+// FILE FORMAT
+//
+// "CSQP", version, then three sections of unsigned LEB128 varints:
+//     operators: count, then (site, slots used, (type id, count) * slots, megamorphic)
+//     branches:  count, then (site, taken, not taken)
+//     calls:     count, then (function, calls)
+// only sites with samples are written
+
+static void _write_varint(FILE* out, unsigned long value) {
+	do {
+		unsigned char byte = value & 0x7f;
+		value >>= 7;
+		fputc(byte | (value ? 0x80 : 0), out);
+	} while (value);
+}
+
+
+static int _read_varint(FILE* in, unsigned long* value) {
+	*value = 0;
+
+	for (int shift = 0; shift < 64; shift += 7) {
+		int byte = fgetc(in);
+		if (byte == EOF)
+			return -1;
+
+		*value |= (unsigned long)(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return 0;
+	}
+
+	return -1;
+}
+
+
+int profile_save(csqr_profile_t* profile, const char* path) {
+	if (!profile || !path)
+		return -1;
+
+	FILE* out = fopen(path, "wb");
+	if (!out)
+		return -1;
+
+	unsigned int operators = 0, branches = 0, functions = 0;
+	profile_summary(profile, &operators, &branches, &functions);
+
+	fwrite(PROFILE_MAGIC, 1, 4, out);
+	_write_varint(out, PROFILE_VERSION);
+
+	_write_varint(out, operators);
+	for (size_t i = 0; i < vec_count(profile->operators); i++) {
+		const operator_site_t* slot = vec_get(profile->operators, i);
+		if (!slot->count[0])
+			continue;
+
+		int used = 0;
+		while (used < PROFILE_TYPE_SLOTS && slot->count[used])
+			used++;
+
+		_write_varint(out, i);
+		_write_varint(out, used);
+		for (int j = 0; j < used; j++) {
+			_write_varint(out, slot->type_id[j]);
+			_write_varint(out, slot->count[j]);
+		}
+		_write_varint(out, slot->megamorphic);
+	}
+
+	_write_varint(out, branches);
+	for (size_t i = 0; i < vec_count(profile->branches); i++) {
+		const branch_site_t* slot = vec_get(profile->branches, i);
+		if (!(slot->taken + slot->not_taken))
+			continue;
+
+		_write_varint(out, i);
+		_write_varint(out, slot->taken);
+		_write_varint(out, slot->not_taken);
+	}
+
+	_write_varint(out, functions);
+	for (size_t i = 0; i < vec_count(profile->calls); i++) {
+		unsigned long calls = *(const unsigned long*)vec_get(profile->calls, i);
+		if (!calls)
+			continue;
+
+		_write_varint(out, i);
+		_write_varint(out, calls);
+	}
+
+	int err = ferror(out);
+	return fclose(out) || err;
+}
+
+
+static int _load_sections(csqr_profile_t* profile, FILE* in) {
+	unsigned long count, site, value;
+
+	if (_read_varint(in, &count))
+		return -1;
+	while (count--) {
+		unsigned long used;
+		if (_read_varint(in, &site) || site >= PROFILE_MAX_SITES
+			|| _read_varint(in, &used) || used > PROFILE_TYPE_SLOTS)
+			return -1;
+
+		operator_site_t* slot = _profile_slot(profile->operators, site);
+		if (!slot)
+			return -1;
+
+		for (unsigned long j = 0; j < used; j++) {
+			if (_read_varint(in, &value))
+				return -1;
+			slot->type_id[j] = value;
+			if (_read_varint(in, &slot->count[j]))
+				return -1;
+		}
+		if (_read_varint(in, &slot->megamorphic))
+			return -1;
+	}
+
+	if (_read_varint(in, &count))
+		return -1;
+	while (count--) {
+		if (_read_varint(in, &site) || site >= PROFILE_MAX_SITES)
+			return -1;
+
+		branch_site_t* slot = _profile_slot(profile->branches, site);
+		if (!slot || _read_varint(in, &slot->taken) || _read_varint(in, &slot->not_taken))
+			return -1;
+	}
+
+	if (_read_varint(in, &count))
+		return -1;
+	while (count--) {
+		if (_read_varint(in, &site) || site >= PROFILE_MAX_SITES)
+			return -1;
+
+		unsigned long* slot = _profile_slot(profile->calls, site);
+		if (!slot || _read_varint(in, slot))
+			return -1;
+	}
+
+	return 0;
+}
+
+
+csqr_profile_t* profile_load(const char* path) {
+	if (!path)
+		return NULL;
+
+	FILE* in = fopen(path, "rb");
+	if (!in)
+		return NULL;
+
+	char magic[4];
+	unsigned long version = 0;
+	csqr_profile_t* profile = NULL;
+
+	if (fread(magic, 1, 4, in) == 4 && !memcmp(magic, PROFILE_MAGIC, 4)
+		&& !_read_varint(in, &version) && version == PROFILE_VERSION) {
+		profile = profile_init();
+		if (profile && _load_sections(profile, in)) {
+			profile_delete(profile);
+			profile = NULL;
+		}
+	}
+
+	fclose(in);
+
+	return profile;
+}
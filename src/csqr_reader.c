@@ -1,15 +1,18 @@
 #include "../include/csqr_reader.h"
+#include "../c_libs/include/small_vector.h"
+#include "../c_libs/include/vector.h"
 
 
 
 // STRUCTS
 
+// most trie nodes have a handful of children, kept inline in the node
+SMALL_VECTOR_DEFINE(trie_child, trie_node_t*, 4)
+
 struct trie_node_s {
 	char key;
 
-	trie_node_t** child;
-	int child_count;
-	int child_max;
+	svec_trie_child_t child;
 
 	trie_node_end_t* is_end_of_word;
 	// NULL if not
@@ -91,6 +94,36 @@ struct program_s {
 };
 
 
+// PROGRAM
+
+program_t* program_init() {
+	program_t* program = malloc(sizeof(program_t));
+	if (!program) {
+		return NULL;
+	}
+
+	program->data_type_count = 0;
+	program->objects = NULL;
+	program->expresions = NULL;
+	program->curr_obj_count = 0;
+	program->max_obj_count = 0;
+
+	return program;
+}
+
+void program_delete(program_t* program) {
+	if (!program) {
+		return;
+	}
+
+	if (program->objects)
+		free(program->objects);
+	if (program->expresions)
+		free(program->expresions);
+	free(program);
+}
+
+
 // WORD TRIE
 
 trie_node_t* trie_create_node(char key, int child_capacity, trie_node_end_t* is_end_of_word) {
@@ -101,11 +134,9 @@ trie_node_t* trie_create_node(char key, int child_capacity, trie_node_end_t* is_
 
 	node->key = key;
 	node->is_end_of_word = is_end_of_word;
-	node->child_count = 0;
-	node->child_max = child_capacity;
 
-	node->child = malloc(child_capacity * sizeof(trie_node_t*));
-	if (!node->child) {
+	svec_trie_child_init(&node->child);
+	if (svec_trie_child_reserve(&node->child, child_capacity)) {
 		free(node);
 		return NULL;
 	}
@@ -115,19 +146,10 @@ trie_node_t* trie_create_node(char key, int child_capacity, trie_node_end_t* is_
 
 // 0 - succes, -1 - error
 int trie_node_add_child(trie_node_t* node, trie_node_t* child) {
-	if (node->child_count == node->child_max) {
-		trie_node_t** tmp = realloc(node->child, (node->child_max * 2) * sizeof(trie_node_t*));
-		if (!tmp) {
-			return -1;
-		}
-
-		node->child_max *= 2;
-
-		node->child = tmp;
+	if (svec_trie_child_push_back(&node->child, child)) {
+		return -1;
 	}
 
-	node->child[node->child_count++] = child;
-
 	return 0;
 }
 
@@ -157,10 +179,12 @@ int trie_insert(word_trie_t* trie, char* string, unsigned int l, unsigned int r,
 
 	for (int i = l; i <= r; i++) {
 		char found = 0;
-		for (int j = 0; j < curr->child_count; j++) {
-			if (curr->child[j]->key == string[i]) {
+		int child_count = svec_trie_child_count(&curr->child);
+		trie_node_t** child = svec_trie_child_data(&curr->child);
+		for (int j = 0; j < child_count; j++) {
+			if (child[j]->key == string[i]) {
 				found = 1;
-				curr = curr->child[j];
+				curr = child[j];
 			}
 		}
 
@@ -200,10 +224,12 @@ trie_node_t* trie_search(word_trie_t* trie, char* string, unsigned int l, unsign
 
 	for (int i = l; i <=r; i++) {
 		char found = 0;
-		for (int j = 0; j < curr->child_count; j++) {
-			if (curr->child[j]->key == string[i]) {
+		int child_count = svec_trie_child_count(&curr->child);
+		trie_node_t** child = svec_trie_child_data(&curr->child);
+		for (int j = 0; j < child_count; j++) {
+			if (child[j]->key == string[i]) {
 				found = 1;
-				curr = curr->child[j];
+				curr = child[j];
 			}
 		}
 
@@ -227,12 +253,11 @@ void _trie_node_del(trie_node_t* node) {
 		free(node->is_end_of_word);
 	}
 
-	for(int i = 0; i < node->child_count; i++) {
-		_trie_node_del(node->child[i]);
+	for(int i = 0; i < svec_trie_child_count(&node->child); i++) {
+		_trie_node_del(svec_trie_child_get(&node->child, i));
 	}
 
-	if (node->child)
-		free(node->child);
+	svec_trie_child_free(&node->child);
 	free(node);
 }
 
@@ -252,107 +277,109 @@ void trie_print(trie_node_t* root, char* curr, int len) {
 		printf("<%s>\n", curr);
 	}
 
-	for (int i = 0; i < root->child_count; i++) {
-		curr[len] = root->child[i]->key;
-		trie_print(root->child[i], curr, len + 1);
+	for (int i = 0; i < svec_trie_child_count(&root->child); i++) {
+		trie_node_t* child = svec_trie_child_get(&root->child, i);
+		curr[len] = child->key;
+		trie_print(child, curr, len + 1);
 	}
 }
 
 // CSQR READER
 
-void _clean_up_to_now(char** lines, int curr_line) {
-	for (int i = 0; i <= curr_line; i++) {
-		free(lines[i]);
+typedef struct source_line_s {
+	char* text;
+	int indent;
+} source_line_t;
+
+// 1 - read a line, 0 - end of file, -1 - error
+int _read_line(FILE* file, source_line_t* line) {
+	char* text = NULL;
+	size_t capacity = 0;
+
+	ssize_t len = getline(&text, &capacity, file);
+	if (len < 0) {
+		free(text);
+		return ferror(file) ? -1 : 0;
 	}
-	free(lines);
+
+	if (len > 0 && text[len - 1] == '\n') {
+		text[len - 1] = '\0';
+	}
+
+	line->text = text;
+	line->indent = 0;
+
+	return 1;
 }
 
-COMP_ERROR create_program(FILE* file, program_t* out) {
-	if (!file)
-		return INTERNAL_ERROR;
+void _lex_line(source_line_t* line) {
+	int j = 0;
 
-	// break into words
+	while (line->text[j] == ' ') {
+		j++;
+	}
 
-	int curr_line = 0;
-	int max_lines = 2;
-	char** lines = malloc(max_lines * sizeof(char*));
-	if (!lines) {
-		return INTERNAL_ERROR;
+	line->indent = j;
+}
+
+// 0 - succes, -1 - error, the line is owned by lines afterwards
+int _generate_line(vector_t* lines, source_line_t* line) {
+	if (vec_push_back(lines, line) != OK) {
+		free(line->text);
+		return -1;
 	}
 
-	int curr_char = 0;
-	int max_chars = 2;
-	lines[0] = malloc(max_chars * sizeof(char));
-	if (!lines[0]) {
-		free(lines);
-		return INTERNAL_ERROR;
+	return 0;
+}
+
+void _free_lines(source_line_t* lines, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		free(lines[i].text);
 	}
+}
 
-	char last_c = 0;
-	char c = 0;
+int _compile_sequential(FILE* file, vector_t* lines) {
+	source_line_t line;
+	int status = 0;
 
-	while ((c = fgetc(file)) != EOF) {
-		if (curr_char == max_chars) {
-			char* tmp = realloc(lines[curr_line], (max_chars *= 2) * sizeof(char));
-			if (!tmp) {
-				_clean_up_to_now(lines, curr_line);
-				return INTERNAL_ERROR;
-			}
-			lines[curr_line] = tmp;
+	while ((status = _read_line(file, &line)) > 0) {
+		_lex_line(&line);
+		if (_generate_line(lines, &line)) {
+			return -1;
 		}
+	}
 
-		last_c = c;
-		lines[curr_line][curr_char] = c;
-
-		if (c == '\n') {
-			lines[curr_line][curr_char] = '\0';
-			curr_line++;
-			curr_char = -1;
-			max_chars = 2;
-
-			if (curr_line == max_lines) {
-				char** tmp = realloc(lines, (max_lines *= 2) * sizeof(char*));
-				if (!tmp) {
-					_clean_up_to_now(lines, curr_line);
-					return INTERNAL_ERROR;
-				}
-				lines = tmp;
-			}
+	return status;
+}
 
-			lines[curr_line] = malloc(max_chars * sizeof(char));
-			if (!lines[curr_line]) {
-				_clean_up_to_now(lines, curr_line - 1);
-				return INTERNAL_ERROR;
-			}
-		}
+COMP_ERROR create_program(FILE* file, program_t* out) {
+	if (!file || !out)
+		return INTERNAL_ERROR;
 
-		curr_char++;
-	}
+	// break into lines, each tagged with its indentation
 
-	lines[curr_line][curr_char] = '\0';
-	if (last_c != '\n') {
-		curr_line++;
-	} else {
-		free(lines[curr_line]);
+	vector_t* lines = vec_init(16, 0, sizeof(source_line_t));
+	if (!lines) {
+		return INTERNAL_ERROR;
 	}
 
-	char** tmp = realloc(lines, curr_line * sizeof(char*));
-	if (!tmp) {
-		_clean_up_to_now(lines, curr_line - 1);
-		free(lines);
+	int status = _compile_sequential(file, lines);
+
+	source_line_t* line = vec_data(lines);
+	int line_count = vec_count(lines);
+
+	if (status) {
+		_free_lines(line, line_count);
+		vec_delete(lines);
 		return INTERNAL_ERROR;
 	}
-	lines = tmp;
-	max_lines = curr_line;
-
-	// At this point lines stores {curr_lines};
 
 	//DEBUG
 #ifdef DEBUG
 	printf("DEBUG:\n");
-	printf("	Lines: <%d>\n", curr_line);
-	for(int i = 0; i < curr_line; i++) {
-		printf("	Line #%d:<%s>\n", i, lines[i]);
+	printf("	Lines: <%d>\n", line_count);
+	for(int i = 0; i < line_count; i++) {
+		printf("	Line #%d:<%s>\n", i, line[i].text);
 	}
 	printf("\n");
 #endif
@@ -360,8 +387,8 @@ COMP_ERROR create_program(FILE* file, program_t* out) {
 
 	word_trie_t* trie = trie_create();
 	if (!trie) {
-		_clean_up_to_now(lines, curr_line - 1);
-		free(lines);
+		_free_lines(line, line_count);
+		vec_delete(lines);
 		return INTERNAL_ERROR;
 	}
 
@@ -372,16 +399,11 @@ COMP_ERROR create_program(FILE* file, program_t* out) {
 	//int scope_id = 0;
 	//int space_count = 0;
 	//int l = 0, r = 0;
-	for (int i = 0; i < curr_line; i++) {
-		int spaces = 0;
-		char* this_line = lines[i];
-		int j = 0;
-
-		while (this_line[j] != ' ') {
-			spaces++;
-			j++;
-		}
-	}
+
+	// the program keeps no reference to the source, so it can be reused
+	_free_lines(line, line_count);
+	vec_delete(lines);
+	trie_delete(trie);
 
 	return SUCCES;
 }
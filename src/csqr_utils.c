@@ -1,8 +1,40 @@
 #include "../include/csqr_utils.h"
 
+#include <unistd.h>
+
 unsigned int is_flag_on(unsigned int flags, FLAGS id) {
 	return (flags & (1 << id));
 }
 void set_flag_on(unsigned int* flags, FLAGS id) {
 	*flags |= (1 << id);
+}
+
+static const char* _private_dir() {
+	static char dir[64];
+	snprintf(dir, sizeof(dir), "%s%u", CSQR_SOCKET_DIR, (unsigned int)getuid());
+	return dir;
+}
+
+const char* csqr_socket_path() {
+	static char socket_path[4096];
+
+	const char* path = getenv(CSQR_SOCKET_ENV);
+	if (path && path[0])
+		return path;
+
+	const char* dir = getenv(CSQR_RUNTIME_ENV);
+	if (!dir || dir[0] != '/')
+		dir = _private_dir();
+
+	snprintf(socket_path, sizeof(socket_path), "%s/%s", dir, CSQR_SOCKET_NAME);
+	return socket_path;
+}
+
+const char* csqr_socket_private_dir(const char* path) {
+	const char* dir = _private_dir();
+	size_t length = strlen(dir);
+
+	if (path && !strncmp(path, dir, length) && path[length] == '/' && !strcmp(path + length + 1, CSQR_SOCKET_NAME))
+		return dir;
+	return NULL;
 }
\ No newline at end of file
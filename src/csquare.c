@@ -2,52 +2,31 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "../include/csqr_reader.h"
+#include "../include/csqr_api.h"
+#include "../include/csqr_batch.h"
+#include "../include/csqr_daemon.h"
 #include "../include/csqr_utils.h"
 
 
-CSQR_EXIT solve_task(csqr_task_t* task) {
-	if (!task)
+CSQR_EXIT run_batch(csqr_task_t* task, int argc, char *argv[]) {
+	csqr_batch_t* batch = csqr_batch_init(task->flags);
+	if (!batch)
 		return NULL_REF_EXIT;
 
-	if (!task->source_code) {
-		printf("Error: No source file given\n\n");
-		return NO_ARGS_EXIT;
-	}
-
-	if (is_flag_on(task->flags, FLAG_VERBOSE)) {
-		printf("Trying to open sourcefile: %s\n", task->source_code);
-	}
-
-	FILE* src = fopen(task->source_code, "r");
-	if (!src) {
-		printf("Error: Could not open file %s\n\n", task->source_code);
-		return NO_FILE_EXIT;
-	}
-
-	if (is_flag_on(task->flags, FLAG_VERBOSE)) {
-		printf("Sourcefile opened\n\n");
+	CSQR_EXIT exit_code = SUCCES_EXIT;
 
-		printf("Preprocessing sourcefile: %s\n\n", task->source_code);
+	// every argument that is not a flag is a script or an @manifest
+	for (int i = 1; i < argc && exit_code == SUCCES_EXIT; i++) {
+		if (argv[i][0] != '-')
+			exit_code = csqr_batch_add(batch, argv[i]);
 	}
 
-	program_t* program = NULL;
-	COMP_ERROR comp = create_program(src, program);
+	if (exit_code == SUCCES_EXIT)
+		exit_code = csqr_batch_run(batch, 0);
 
-	if (comp) {
-		printf("Error while compiling program. error code = <%d>\n\n", comp);
-		return COMPILATION_ERROR_EXIT;
-	}
-
-	fclose(src);
-
-	if (is_flag_on(task->flags, FLAG_VERBOSE)) {
-		printf("Program succesfuly proccessed with exit code = <%d>\n\n", comp);
-
-		printf("Executing the program\n\n");
-	}
+	csqr_batch_delete(batch);
 
-	return SUCCES_EXIT;
+	return exit_code;
 }
 
 
@@ -55,6 +34,7 @@ int main(int argc, char *argv[]) {
 	csqr_task_t task;
 	task.flags = 0;
 	task.source_code = NULL;
+	int sources = 0;
 
 	for (int i = 1; i < argc; i++) {
 		if (argv[i][0] == '-') {
@@ -69,6 +49,15 @@ int main(int argc, char *argv[]) {
 				case 'v':
 					set_flag_on(&(task.flags), FLAG_VERBOSE);
 				break;
+				case 'b':
+					set_flag_on(&(task.flags), FLAG_BATCH);
+				break;
+				case 'd':
+					set_flag_on(&(task.flags), FLAG_DAEMON);
+				break;
+				case 'p':
+					set_flag_on(&(task.flags), FLAG_PROFILE);
+				break;
 				default:
 					printf("Unknoun flag %s, exiting\n", argv[i]);
 					return UNKNOUN_FLAG_EXIT;
@@ -79,13 +68,24 @@ int main(int argc, char *argv[]) {
 		}
 
 		// if not flag, argument must be source file name
-		if (task.source_code) {
-			printf("Please provide only one source file, exiting!\n");
-			return TOO_MANY_ARGS_EXIT;
-		}
-		
+		sources++;
 		task.source_code = argv[i];
 	}
 
+	// the daemon gets its scripts from the clients
+	if (is_flag_on(task.flags, FLAG_DAEMON)) {
+		return csqr_daemon_run(csqr_socket_path(), task.flags);
+	}
+
+	// batch mode collects the sources only once all flags are known
+	if (is_flag_on(task.flags, FLAG_BATCH)) {
+		return run_batch(&task, argc, argv);
+	}
+
+	if (sources > 1) {
+		printf("Please provide only one source file, exiting!\n");
+		return TOO_MANY_ARGS_EXIT;
+	}
+
 	return solve_task(&task);
 }
@@ -1,10 +1,68 @@
 #include <stdio.h>
 
 #include "../include/csqr_reader.h"
+#include "../include/csqr_profile.h"
 
 int main(int argc, char *argv[]) {
-	for(int i = 0; i < argc; i++) {
-		printf("%s\n", argv[i]);
+	unsigned int flags = 0;
+	char* source_code = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		if (argv[i][0] == '-') {
+			if (strlen(argv[i]) > 2) {
+				printf("Unknoun flag %s, exiting\n", argv[i]);
+				return UNKNOUN_FLAG_EXIT;
+			}
+
+			switch (argv[i][1]) {
+				case 'v':
+					set_flag_on(&flags, FLAG_VERBOSE);
+				break;
+				case 'p':
+					set_flag_on(&flags, FLAG_PROFILE);
+				break;
+				default:
+					printf("Unknoun flag %s, exiting\n", argv[i]);
+					return UNKNOUN_FLAG_EXIT;
+				break;
+			}
+
+			continue;
+		}
+
+		if (source_code) {
+			printf("Please provide only one source file, exiting!\n");
+			return TOO_MANY_ARGS_EXIT;
+		}
+
+		source_code = argv[i];
+	}
+
+	if (!source_code) {
+		printf("Error: No source file given\n\n");
+		return NO_ARGS_EXIT;
+	}
+
+	// with -p the profile recorded by csquare -p guides code generation:
+	// dominant operand types get guarded specialized code (profile_emit_type_guard)
+	// and biased branches are laid out for their direction (profile_emit_branch)
+	csqr_profile_t* profile = NULL;
+	if (is_flag_on(flags, FLAG_PROFILE)) {
+		char path[4096];
+		if (profile_path(source_code, path, sizeof(path)) || !(profile = profile_load(path))) {
+			printf("Error: Could not load profile of %s\n\n", source_code);
+			return NO_FILE_EXIT;
+		}
+
+		if (is_flag_on(flags, FLAG_VERBOSE)) {
+			unsigned int operators, branches, functions;
+			profile_summary(profile, &operators, &branches, &functions);
+			printf("Loaded profile %s: %u operator sites, %u branch sites, %u functions\n\n",
+				path, operators, branches, functions);
+		}
 	}
-	return 0;
-}
\ No newline at end of file
+
+	profile_delete(profile);
+
+	return SUCCES_EXIT;
+}